@@ -0,0 +1,45 @@
+# Writes header with SPIR-V of every shader as constexpr array of 32-bit words.
+# SPIRV_FILES - compiled shaders named <shader file name>.spv, separated with "|".
+# OUTPUT_FILE - generated header.
+
+string(REPLACE "|" ";" SPIRV_FILES "${SPIRV_FILES}")
+
+set(SHADER_ARRAYS "")
+set(SHADER_ENTRIES "")
+set(SHADER_COUNT 0)
+foreach(SPIRV_FILE IN LISTS SPIRV_FILES)
+    get_filename_component(SPIRV_FILE_NAME ${SPIRV_FILE} NAME)
+    string(REGEX REPLACE "\\.spv$" "" SHADER_NAME ${SPIRV_FILE_NAME})
+    string(MAKE_C_IDENTIFIER ${SHADER_NAME} ARRAY_NAME)
+
+    # SPIR-V words are little-endian, so bytes of every word are written in reverse order.
+    file(READ ${SPIRV_FILE} SPIRV_HEX HEX)
+    string(REGEX REPLACE "([0-9a-f][0-9a-f])([0-9a-f][0-9a-f])([0-9a-f][0-9a-f])([0-9a-f][0-9a-f])"
+        "0x\\4\\3\\2\\1," SPIRV_WORDS "${SPIRV_HEX}")
+
+    string(APPEND SHADER_ARRAYS "constexpr uint32_t ${ARRAY_NAME}[] = { ${SPIRV_WORDS} };\n")
+    string(APPEND SHADER_ENTRIES "    Shader { \"${SHADER_NAME}\", ${ARRAY_NAME}, sizeof(${ARRAY_NAME}) },\n")
+    math(EXPR SHADER_COUNT "${SHADER_COUNT} + 1")
+endforeach()
+
+file(WRITE ${OUTPUT_FILE}
+"// Generated by cmake/embed_spirv.cmake from resources/shaders, do not edit.
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+namespace EmbeddedShaders {
+
+struct Shader {
+    std::string_view name; // shader file name, e.g. painting.frag
+    const uint32_t* code;
+    size_t size; // in bytes
+};
+
+${SHADER_ARRAYS}
+constexpr std::array<Shader, ${SHADER_COUNT}> SHADERS = {
+${SHADER_ENTRIES}};
+} // namespace EmbeddedShaders
+")
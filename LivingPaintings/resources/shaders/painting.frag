@@ -3,10 +3,6 @@
 
 precision highp float;
 
-const uint EFFECTS_COUNT = 3;
-const uint MASKS_COUNT = EFFECTS_COUNT + 1;
-const uint PACKED_EFFECTS_COUNT = (EFFECTS_COUNT + 3) / 4;
-
 layout(set = 1, binding = 0) uniform sampler2D paintingTexSampler[];
 layout(binding = 3) uniform sampler2D heightMapTexSampler;
 layout(binding = 4) uniform MouseControls {
@@ -16,25 +12,29 @@ layout(binding = 4) uniform MouseControls {
     bool pixelScaling;
 	int maskEffectIndex;
 } mouseMaskControl;
-layout(binding = 5) uniform sampler2D selectedPositionsMask[MASKS_COUNT];
+layout(binding = 5) uniform usampler2D selectedPositionsMask; // bit i is set when texel is selected in mask i
 layout(binding = 6) uniform RuntimeProperties {
 	float time;
 } prop;
 layout(binding = 7) uniform EffectParams {
-    uvec4 enabledEffects[PACKED_EFFECTS_COUNT];
+	uvec4 effectMasks; // mask index of every effect id, 0 when effect is not in the set
+    uint enabledEffects; // bit i is set when effect of mask i + 1 is enabled
 	uint highlightSelectedPixels;
+	uint masksCount;
     float heightRange; // Scale factor that is used to vary the range of the height values
 	float noiseScale;
 	float distortionModifier;
 	float parallaxHeightScale;
 	float amplifyFlickeringLight;
 	float amplifyHighlight;
+	float parallaxLayers;
 } effectsParams;
 
 layout(binding = 8) uniform LightParams {
   vec3 pos;
   float surfaceColorModifier;
 } lightParams;
+layout(binding = 10) uniform sampler2D noiseTexSampler;
 
 layout(location = 0) in vec2 fragTexCoord;
 layout(location = 1) in vec3 cameraView;
@@ -45,33 +45,48 @@ layout(location = 5) in vec3 inTangentLightPos;
 
 layout(location = 0) out vec4 outFragColor;
 
-const vec3 maskColors[MASKS_COUNT] = { vec3(0.7f), vec3(0.5f, 1.0f, 0.4f), vec3(0.01f, 0.01f, 1.26f), vec3(0.97f, 0.011f, 0.26f) };
+const vec3 maskColors[4] = { vec3(0.7f), vec3(0.5f, 1.0f, 0.4f), vec3(0.01f, 0.01f, 1.26f), vec3(0.97f, 0.011f, 0.26f) };
 const vec3 colorPallete [2] = { vec3(0.06f, 0.052f, 0.074f), vec3(0.0047f, 0.0094f, 0.026f) }; // cold and warm color specified by RGB values in range [0, 1]
 
 const float gamma = 2.2f;
 
 const float textureScale = 0.2f;
 
-vec2 random2(vec2 st){
-    st = vec2( dot(st,vec2(127.1,311.7)),
-              dot(st,vec2(269.5,183.3)) );
-    return -1.0 + 2.0*fract(sin(st)*43758.5453123);
+const float selectedRegionHighlight = 70.0f / 255.0f;
+
+//	Fetch bits of every mask for the texel, masks are not filtered.
+uint fetchMasks(vec2 texCoord) {
+	ivec2 maskSize = textureSize(selectedPositionsMask, 0);
+	ivec2 texelCoord = clamp(ivec2(texCoord * maskSize), ivec2(0), maskSize - 1);
+	return texelFetch(selectedPositionsMask, texelCoord, 0).r;
 }
 
-// Gradient Noise by Inigo Quilez - iq/2013
-// https://www.shadertoy.com/view/XdXGW8
-float gradientNoise(vec2 st) {
-    vec2 i = floor(st);
-    vec2 f = fract(st);
+bool isSelected(uint masks, uint maskIndex) {
+	return (masks & (1u << maskIndex)) != 0u;
+}
 
-    vec2 u = f*f*(3.0-2.0*f); // cubic Hermit curve
+bool isEffectEnabled(uint effectIndex) {
+	return (effectsParams.enabledEffects & (1u << effectIndex)) != 0u;
+}
 
-    return mix( mix( dot( random2(i + vec2(0.0,0.0) ), f - vec2(0.0,0.0) ),
-                     dot( random2(i + vec2(1.0,0.0) ), f - vec2(1.0,0.0) ), u.x),
-                mix( dot( random2(i + vec2(0.0,1.0) ), f - vec2(0.0,1.0) ),
-                     dot( random2(i + vec2(1.0,1.0) ), f - vec2(1.0,1.0) ), u.x), u.y);
+// Ids of effects, they match Constants::EffectId.
+const uint SWAY_EFFECT = 0u;
+const uint FLICKERING_LIGHT_EFFECT = 1u;
+const uint HIGHLIGHT_EFFECT = 2u;
+
+// Effect is applied when it is in the effect set, it is enabled and its mask is selected.
+bool isEffectApplied(uint masks, uint effectId) {
+	uint maskIndex = effectsParams.effectMasks[effectId];
+	return maskIndex != 0u && isSelected(masks, maskIndex) && isEffectEnabled(maskIndex - 1u);
 }
 
+//	Masks that are added at runtime past predefined colors get color from their index.
+vec3 getMaskColor(uint maskIndex) {
+	if (maskIndex < uint(maskColors.length())) {
+		return maskColors[maskIndex];
+	}
+	return 0.5f + 0.5f * cos(6.2831f * (float(maskIndex) * 0.618f + vec3(0.0f, 0.33f, 0.67f)));
+}
 
 /*
   Implementation of Parallax Mapping with Offset Limiting. This is done by calculating the camera's direction
@@ -136,35 +151,32 @@ vec2 parallaxOcclusionMapping(vec3 viewDirection, vec2 texCoord, float layerNumb
 void main() {
 
  	// Create animations or effects for selected objects that was selected.
-	float selectedObjectMask = texture(selectedPositionsMask[0], fragTexCoord).r;
-	float distortionMask = texture(selectedPositionsMask[1], fragTexCoord).r;
-	float flickeringMask = texture(selectedPositionsMask[2], fragTexCoord).r;
-	float highlightMask = texture(selectedPositionsMask[3], fragTexCoord).r;
+	uint selectedMasks = fetchMasks(fragTexCoord);
 
 	vec3 mixColor = vec3(0.0f);
-	vec2 noiseScale = vec2(effectsParams.noiseScale);
-	vec2 scaledFragTexCoord = fragTexCoord * noiseScale;
-	float noise = gradientNoise(scaledFragTexCoord);	
+	// Noise is baked by computeNoise.comp whenever noise scale is changed, texture holds whole lattice cells.
+	float noiseTiling = effectsParams.noiseScale / max(ceil(effectsParams.noiseScale), 1.0f);
+	float noise = texture(noiseTexSampler, fragTexCoord * noiseTiling).r;
 	vec2 UV = fragTexCoord;
 	// Effect for object construction mask 
 
 	// Sway effect
-	if(distortionMask != 0 && effectsParams.enabledEffects[0][0] == 1) {
+	if(isEffectApplied(selectedMasks, SWAY_EFFECT)) {
 		UV.x += sin(prop.time) * noise * effectsParams.distortionModifier;
 		UV.y += sin(prop.time) * noise * effectsParams.distortionModifier;
 	}
 	// Flickering effect for object construction mask 
-	if(flickeringMask != 0 && effectsParams.enabledEffects[0][1] == 1) {
+	if(isEffectApplied(selectedMasks, FLICKERING_LIGHT_EFFECT)) {
 		mixColor += mix(vec3(0.0f), maskColors[0], abs(sin(prop.time)) * noise) * effectsParams.amplifyFlickeringLight;
 	}
 	// Highlight effect
-	if(highlightMask != 0 && effectsParams.enabledEffects[0][2] == 1) {
+	if(isEffectApplied(selectedMasks, HIGHLIGHT_EFFECT)) {
 		mixColor += mix(maskColors[1], maskColors[2], abs(sin(prop.time)) * noise) * effectsParams.amplifyHighlight;
 	}
 
 	//	Calculate Parallax mapping
 	vec3 viewDirection = normalize(inTangentViewPos - inTangentFragPos);
-	UV = parallaxOcclusionMapping(viewDirection, UV, 50.0f);
+	UV = parallaxOcclusionMapping(viewDirection, UV, effectsParams.parallaxLayers);
 
 	vec2 texSize = textureSize(paintingTexSampler[0], 0);
 	vec3 texColor = texture(paintingTexSampler[gl_Layer], UV).rgb + mixColor;
@@ -220,8 +232,9 @@ void main() {
 		vec2 texUV = (((fragTexCoord - mousePos) * textureScale) + (mousePos * textureScale) / textureScale);
 
 		vec4 scaledTex = texture(paintingTexSampler[0], texUV).rgba;
-		vec4 selectedPosColor = texture(selectedPositionsMask[mouseMaskControl.maskEffectIndex], texUV).rrra;
-		vec3 revertPosColor = texture(selectedPositionsMask[mouseMaskControl.maskEffectIndex], fragTexCoord).rrr;
+		uint maskIndex = uint(mouseMaskControl.maskEffectIndex);
+		vec4 selectedPosColor = vec4(vec3(isSelected(fetchMasks(texUV), maskIndex) ? selectedRegionHighlight : 0.0f), 1.0f);
+		vec3 revertPosColor = vec3(isSelected(selectedMasks, maskIndex) ? selectedRegionHighlight : 0.0f);
 		
 		scaledTex.rgb *= square;
 		scaledTex.rgb -= revertPosColor;
@@ -238,8 +251,10 @@ void main() {
 	//Highlight every selected pixel in the masks
 	if(effectsParams.highlightSelectedPixels == 1) {
 		vec3 selectedPosColor = vec3(0);
-		for(uint maskIndex = 0; maskIndex < MASKS_COUNT; maskIndex++) {
-			selectedPosColor += texture(selectedPositionsMask[maskIndex], fragTexCoord).rrr * maskColors[maskIndex];
+		for(uint maskIndex = 0; maskIndex < effectsParams.masksCount; maskIndex++) {
+			if (isSelected(selectedMasks, maskIndex)) {
+				selectedPosColor += selectedRegionHighlight * getMaskColor(maskIndex);
+			}
 		}
 		outFragColor = outFragColor + vec4(selectedPosColor, 1.0f);
 	}
@@ -1,9 +1,14 @@
 #version 460
 
 #if VULKAN
-layout(set = 0, binding = 0) uniform InstanceUbo {
+struct InstanceData {
     mat4 model;
-} uboInstance;
+    uint textureSlot; // element of bindless texture array
+};
+
+layout(std430, set = 0, binding = 0) readonly buffer InstanceBuffer {
+    InstanceData instances[];
+};
 
 layout(binding = 1) uniform ViewUbo {
     mat4 view;
@@ -17,14 +22,15 @@ layout(location = 0) out vec3 position;
 layout(location = 1) out vec2 texCoord;
 layout(location = 2) out vec3 cameraView;
 layout(location = 3) out mat4 model;
-layout(location = 7) out int instanceID;
+layout(location = 7) out int textureSlot;
 
 void main() {
-	gl_Position = uboView.proj * uboView.view * uboInstance.model * vec4(inPosition, 1.0f);
+    InstanceData instance = instances[gl_InstanceIndex];
+	gl_Position = uboView.proj * uboView.view * instance.model * vec4(inPosition, 1.0f);
     position = inPosition;
     texCoord = inTexCoord;
     cameraView = uboView.view[2].xyz;
-    model = uboInstance.model;
-    instanceID = gl_InstanceIndex;
+    model = instance.model;
+    textureSlot = int(instance.textureSlot);
 }
 #endif
\ No newline at end of file
@@ -0,0 +1,43 @@
+#version 460
+
+layout(binding = 11) uniform sampler2D sceneTexSampler;
+layout(push_constant) uniform UpscaleParams {
+	vec2 uvScale; // part of the scene image that painting was rendered to
+	vec2 texelSize;
+	float sharpness;
+} upscaleParams;
+
+layout(location = 0) in vec2 fragTexCoord;
+
+layout(location = 0) out vec4 outFragColor;
+
+//	Sample only rendered part of the scene image, so bilinear filter does not blend in stale texels.
+vec3 sampleScene(vec2 texCoord) {
+	vec2 halfTexel = upscaleParams.texelSize * 0.5f;
+	return texture(sceneTexSampler, clamp(texCoord, halfTexel, upscaleParams.uvScale - halfTexel)).rgb;
+}
+
+/*
+  Bilinear upscale with sharpening. Difference between the bilinear sample and its four neighbour
+  texels is added back to the sample to restore contrast lost by the upscale, where result is clamped
+  to the neighbourhood range, so sharpening does not produce halos around the edges.
+
+  Parameters:
+	upscaleParams.sharpness - 0 gives plain bilinear upscale, 1 gives the strongest sharpening.
+*/
+void main() {
+	vec2 texCoord = fragTexCoord * upscaleParams.uvScale;
+	vec2 texelSize = upscaleParams.texelSize;
+
+	vec3 center = sampleScene(texCoord);
+	vec3 up = sampleScene(texCoord - vec2(0.0f, texelSize.y));
+	vec3 down = sampleScene(texCoord + vec2(0.0f, texelSize.y));
+	vec3 left = sampleScene(texCoord - vec2(texelSize.x, 0.0f));
+	vec3 right = sampleScene(texCoord + vec2(texelSize.x, 0.0f));
+
+	vec3 minColor = min(center, min(min(up, down), min(left, right)));
+	vec3 maxColor = max(center, max(max(up, down), max(left, right)));
+	vec3 sharpened = center + (4.0f * center - (up + down + left + right)) * 0.25f * upscaleParams.sharpness;
+
+	outFragColor = vec4(clamp(sharpened, minColor, maxColor), 1.0f);
+}
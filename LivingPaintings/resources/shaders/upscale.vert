@@ -0,0 +1,9 @@
+#version 460
+
+layout(location = 0) out vec2 fragTexCoord;
+
+//	Fullscreen triangle, which covers the viewport with texture coordinates in range [0, 1].
+void main() {
+	fragTexCoord = vec2((gl_VertexIndex << 1) & 2, gl_VertexIndex & 2);
+	gl_Position = vec4(fragTexCoord * 2.0f - 1.0f, 0.0f, 1.0f);
+}
@@ -0,0 +1,57 @@
+#include "../vulkan/engine.h"
+#include <algorithm>
+#include <cstdlib>
+#include <string>
+
+using Constants::WINDOW_WIDTH;
+using Constants::WINDOW_HEIGHT;
+
+/* Replays scripted selections and brush strokes against the bundled painting and prints latency of every stage
+   from prompt enqueue to the first presented frame. Window is hidden, software rasterizer of Mesa is selected
+   unless another driver is selected with VK_LOADER_DRIVERS_SELECT, so results do not depend on the GPU.
+   Usage: SelectionBenchmark [repetitions] */
+
+const char* DRIVERS_SELECT_VARIABLE = "VK_LOADER_DRIVERS_SELECT";
+const char* LAVAPIPE_DRIVER = "*lvp*";
+const int DEFAULT_REPETITIONS = 10;
+
+// Positions are relative to the window, so script does not depend on window resolution.
+static glm::dvec2 windowPos(double x, double y)
+{
+    return glm::dvec2(x * WINDOW_WIDTH, y * WINDOW_HEIGHT);
+}
+
+static std::vector<ScriptedInput> createInputScript(int repetitions)
+{
+    const std::vector<ScriptedInput> sequence = {
+        { ScriptedInput::BOX, windowPos(0.62, 0.05), windowPos(0.82, 0.35) },
+        { ScriptedInput::POSITIVE_POINT, windowPos(0.72, 0.30), {} },
+        { ScriptedInput::NEGATIVE_POINT, windowPos(0.66, 0.08), {} },
+        { ScriptedInput::POINT, windowPos(0.12, 0.55), {} },
+        { ScriptedInput::POSITIVE_POINT, windowPos(0.16, 0.70), {} },
+        { ScriptedInput::BOX, windowPos(0.30, 0.60), windowPos(0.55, 0.95) },
+        { ScriptedInput::BRUSH, windowPos(0.40, 0.40), windowPos(0.60, 0.45) },
+        { ScriptedInput::UNSELECT_BRUSH, windowPos(0.45, 0.38), windowPos(0.55, 0.47) },
+    };
+
+    std::vector<ScriptedInput> script;
+    for (int repetition = 0; repetition < repetitions; repetition++) {
+        script.insert(script.end(), sequence.begin(), sequence.end());
+    }
+    return script;
+}
+
+int main(int argc, char* argv[])
+{
+    if (std::getenv(DRIVERS_SELECT_VARIABLE) == nullptr) {
+#ifdef _WIN32
+        _putenv_s(DRIVERS_SELECT_VARIABLE, LAVAPIPE_DRIVER);
+#else
+        setenv(DRIVERS_SELECT_VARIABLE, LAVAPIPE_DRIVER, 0);
+#endif
+    }
+    const int repetitions = argc > 1 ? std::max(std::stoi(argv[1]), 1) : DEFAULT_REPETITIONS;
+
+    Engine engine;
+    return engine.runBenchmark(createInputScript(repetitions)) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,35 @@
+#include "mask_ingestion.h"
+
+cv::Rect MaskIngestion::thresholdDecodedMask(const cv::Mat& decodedMask, cv::Mat& binaryMask)
+{
+    cv::Mat maskChannel = decodedMask;
+    if (decodedMask.channels() > 1) {
+        cv::extractChannel(decodedMask, maskChannel, 0);
+    }
+    cv::compare(maskChannel, DECODED_MASK_THRESHOLD, binaryMask, cv::CMP_GT);
+    return cv::boundingRect(binaryMask);
+}
+
+// Rows are stamped in parallel stripes, and inner loop has no branches, so it is vectorized.
+uint32_t MaskIngestion::stampLabels(const cv::Mat& binaryMask, cv::Point maskPos, uint32_t imageWidth, uint16_t label,
+    uint16_t* labels, uchar* selectedPixels)
+{
+    std::atomic<uint32_t> stampedPixelCount = 0;
+    cv::parallel_for_(cv::Range(0, binaryMask.rows), [&](const cv::Range& rows) {
+        uint32_t rowsPixelCount = 0;
+        for (int y = rows.start; y < rows.end; y++) {
+            const uchar* binaryRow = binaryMask.ptr<uchar>(y);
+            const size_t rowBegin = static_cast<size_t>(maskPos.y + y) * imageWidth + maskPos.x;
+            uint16_t* labelRow = labels + rowBegin;
+            uchar* selectedRow = selectedPixels + rowBegin;
+            for (int x = 0; x < binaryMask.cols; x++) {
+                const bool stamped = binaryRow[x] != 0 && labelRow[x] == UNSELECTED_REGION_LABEL;
+                labelRow[x] = stamped ? label : labelRow[x];
+                selectedRow[x] = stamped ? SELECTED_REGION_HIGHLIGHT : selectedRow[x];
+                rowsPixelCount += stamped;
+            }
+        }
+        stampedPixelCount += rowsPixelCount;
+    });
+    return stampedPixelCount;
+}
@@ -0,0 +1,23 @@
+#pragma once
+#include "../vulkan/consts.h"
+#include <atomic>
+#include <cstdint>
+#include <opencv2/core.hpp>
+#include <opencv2/imgproc.hpp>
+
+using Constants::DECODED_MASK_THRESHOLD;
+using Constants::SELECTED_REGION_HIGHLIGHT;
+using Constants::UNSELECTED_REGION_LABEL;
+
+/* Kernels that turn decoded mask of the model into region labels of the mask store. They work on plain
+   arrays of the store, so they are tested against scalar loops without the model and the device. */
+class MaskIngestion {
+
+public:
+    // Returns bounds of selected pixels, first channel is used when decoded mask has several channels.
+    static cv::Rect thresholdDecodedMask(const cv::Mat& decodedMask, cv::Mat& binaryMask);
+    /* Stamps label into unselected pixels of binary mask that is placed at the image position. Labels and
+       selected pixels are rows of image with the given width. Returns number of stamped pixels. */
+    static uint32_t stampLabels(const cv::Mat& binaryMask, cv::Point maskPos, uint32_t imageWidth, uint16_t label,
+        uint16_t* labels, uchar* selectedPixels);
+};
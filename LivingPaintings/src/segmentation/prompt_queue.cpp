@@ -0,0 +1,78 @@
+#include "prompt_queue.h"
+
+void PromptQueue::push(SegmentationPrompt prompt)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (closed) {
+            return;
+        }
+        generation++;
+        prompt.generation = generation;
+        prompt.pushTime = std::chrono::steady_clock::now();
+        maskGenerations.insert_or_assign(prompt.maskIndex, generation);
+        pendingPrompts.insert_or_assign(prompt.maskIndex, std::move(prompt));
+    }
+    promptPushed.notify_one();
+}
+
+std::optional<SegmentationPrompt> PromptQueue::waitAndPop()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    promptPushed.wait(lock, [this] { return closed || !pendingPrompts.empty(); });
+    if (closed) {
+        return std::nullopt;
+    }
+
+    std::optional<SegmentationPrompt> prompt = std::move(pendingPrompts.begin()->second);
+    pendingPrompts.erase(pendingPrompts.begin());
+    promptDecoded = true;
+    return prompt;
+}
+
+void PromptQueue::finish()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        promptDecoded = false;
+    }
+    promptFinished.notify_all();
+}
+
+bool PromptQueue::isSuperseded(const SegmentationPrompt& prompt)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return closed || prompt.generation != maskGenerations[prompt.maskIndex];
+}
+
+bool PromptQueue::isIdle()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return pendingPrompts.empty() && !promptDecoded;
+}
+
+void PromptQueue::waitUntilIdle()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    promptFinished.wait(lock, [this] { return closed || (pendingPrompts.empty() && !promptDecoded); });
+}
+
+// Pending prompts are dropped and waiting threads are woken up, so they can be joined.
+void PromptQueue::close()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        closed = true;
+        pendingPrompts.clear();
+    }
+    promptPushed.notify_all();
+    promptFinished.notify_all();
+}
+
+void PromptQueue::reopen()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    closed = false;
+    promptDecoded = false;
+    maskGenerations.clear();
+}
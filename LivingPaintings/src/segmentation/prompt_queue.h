@@ -0,0 +1,54 @@
+#pragma once
+#include "glm/glm.hpp"
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <list>
+#include <map>
+#include <mutex>
+#include <opencv2/core.hpp>
+#include <optional>
+
+/* All prompts of one selection, positions are in window coordinates that are passed to the model.
+   Prompts that refine the selection are appended to it, so one decoder run selects the whole region. */
+struct SegmentationPrompt {
+    std::list<cv::Point> points;
+    std::list<cv::Point> negativePoints;
+    cv::Rect box; // empty when selection has no box
+    glm::uvec2 imagePos; // pixel of the image that region is selected from
+    uint16_t maskIndex = 0;
+    uint64_t selectionId = 0; // region of the same selection is replaced when selection is refined
+    uint64_t generation = 0;
+    std::chrono::steady_clock::time_point pushTime;
+};
+
+/* Queue of prompts between input callbacks and segmentation thread. Only the latest prompt of every mask
+   is kept, so prompts that arrive while inference is running are coalesced into one. Pushed prompt holds all
+   prompts of its selection, so it supersedes the previous prompt of the mask, and result of superseded prompt
+   is discarded. Prompt of one mask does not supersede prompt of another mask, so every mask keeps its own slot.
+   Prompts are popped by the single decoder thread, model has one decoder session for all masks. */
+class PromptQueue {
+
+    std::mutex mutex;
+    std::condition_variable promptPushed;
+    std::condition_variable promptFinished;
+    std::map<uint16_t, SegmentationPrompt> pendingPrompts; // by mask index
+    std::map<uint16_t, uint64_t> maskGenerations; // generation of the latest prompt of the mask
+    bool promptDecoded = false; // prompt is popped and not finished yet
+    uint64_t generation = 0;
+    bool closed = false;
+
+public:
+    void push(SegmentationPrompt prompt);
+    // Blocks until prompt of any mask is pushed, returns nothing when queue is closed.
+    std::optional<SegmentationPrompt> waitAndPop();
+    // Popped prompt is finished after its region is selected or discarded.
+    void finish();
+    bool isSuperseded(const SegmentationPrompt& prompt);
+    // Queue is idle when there are no pending prompts and every popped prompt is finished.
+    bool isIdle();
+    // Blocks until queue is idle or closed.
+    void waitUntilIdle();
+    void close();
+    void reopen();
+};
@@ -3,47 +3,112 @@
 
 using Runtime::PATH_PARAMS;
 
-using Constants::BUMP_TEXTURE_FORMAT;
 using Constants::SELECTED_REGION_HIGHLIGHT;
-using Constants::MASKS_COUNT;
+using Constants::MAX_MASKS_COUNT;
 using Constants::WINDOW_WIDTH;
 using Constants::WINDOW_HEIGHT;
 using Constants::INPAINTING_HISTORY_FOLDER_NAME;
 using Constants::IMAGE_TEXTURE_FORMAT;
+using Constants::UNSELECTED_REGION_LABEL;
+using Constants::BRUSH_REGION_LABEL;
+using Constants::SELECTION_BOX_MIN_SIZE;
+using Constants::AUTO_SEGMENTATION_GRID_SIZE;
+using Constants::MAX_BRUSH_SAMPLES;
+using Constants::DEFAULT_BRUSH_RADIUS;
+using Constants::DEFAULT_BRUSH_HARDNESS;
 
 const int THREAD_NUMBER = std::thread::hardware_concurrency();
 
-bool runningSegmentation = true;
 bool imageLoaded = false;
 std::string imagePath;
 
 std::shared_ptr<GLFWwindow> pWindow = nullptr;
 std::shared_ptr<Controls::MouseControl> mouseControl = nullptr;
 std::shared_ptr<Sam> samModel = nullptr;
+std::once_flag samModelBuilt;
+// Model is used by one thread at a time, job of automatic segmentation holds it between its progress reports.
+std::mutex samModelMutex;
+// Key of the image which embedding the model holds, encoder is not run when the same image is loaded.
+std::optional<uint64_t> loadedEmbeddingKey;
 glm::uvec2 modelResolution;
 
 cv::Mat latestImageTexture;
 glm::uvec2 imageResolution;
 glm::uvec2 windowResolution;
 
-std::unordered_set<glm::uvec2> brushPositions { { 0, 0 }, { 1, 0 }, { -1, 0 }, { 0, 1 },
-    { 0, -1 }, { 1, 1 }, { -1, -1 }, { 1, -1 },
-    { -1, 1 } };
+// Brush samples recorded by cursor callbacks, they are stamped into the packed mask on GPU with following frames.
+std::vector<glm::vec4> brushSamples;
+std::optional<glm::vec2> lastBrushPos;
+float brushRadius = DEFAULT_BRUSH_RADIUS;
+float brushHardness = DEFAULT_BRUSH_HARDNESS;
+// Rectangle of texels stamped by brush since the mask was read back, it is empty when min is greater than max.
+glm::uvec2 brushStampedMin = glm::uvec2(std::numeric_limits<uint32_t>::max());
+glm::uvec2 brushStampedMax = glm::uvec2(0);
+// Time of the earliest brush sample that is not stamped yet.
+std::optional<SelectionLatency::Clock::time_point> brushInputTime;
 
-std::array<std::unordered_map<glm::uvec2, glm::uvec2>, MASKS_COUNT> objectPositions {};
-std::array<uint32_t, MASKS_COUNT> selectedObjectsSize{};
-std::array<uint32_t, MASKS_COUNT> currentSelectedObjectsSize{};
+SelectionLatency selectionLatency;
+
+/* Selected pixels of a mask. Every pixel keeps label of the region it was selected with, so selecting
+   is a write, and region is removed by clearing its label. Regions are described in a small table
+   indexed by label and labels of removed regions are reused. Mask with highlight values is kept up to
+   date with labels, and rectangle of pixels that changed since the last upload is tracked. */
+struct MaskRegions {
+    struct Region {
+        glm::uvec2 seedPos; // position that region was selected from
+        uint32_t pixelCount;
+        glm::uvec2 boundsMin;
+        glm::uvec2 boundsMax;
+        uint64_t selectionId; // selection of segmentation prompts that region is selected with
+    };
+
+    std::vector<uint16_t> labels;
+    std::vector<uchar> selectedPixels;
+    std::vector<Region> regions;
+    std::vector<uint16_t> freeLabels;
+    uint32_t selectedPixelCount = 0;
+    glm::uvec2 dirtyMin; // dirty rectangle is empty when min is greater than max
+    glm::uvec2 dirtyMax;
+};
+
+// Sized at initialization by the number of masks.
+std::vector<MaskRegions> objectPositions {};
+// Masks are edited by input callbacks and segmentation thread and read by the upload.
+std::mutex maskRegionsMutex;
 
 cv::Mat image;
-cv::Mat selectedPosMask;
+/* Mask of the last selection at decoder resolution, it is upscaled to the image only for inpainting. Object
+   selected by automatic segmentation label is kept at image resolution. */
+cv::Mat decodedPosMask;
+
+PromptQueue segmentationPrompts;
 
-std::queue<glm::uvec2> inputPositions {};
+/* Objects found by automatic segmentation of the loaded painting. Labels are at image resolution and 0 is
+   not an object, bounds of every label limit the pixels that are scanned when object is selected. */
+struct AutoSegmentation {
+    cv::Mat labels;
+    std::vector<cv::Rect> labelBounds;
+};
+AutoSegmentation autoSegmentation;
+// Set after labels are written by the job, input callbacks read labels only when it is set.
+std::atomic<bool> autoSegmentationReady = false;
+std::atomic<float> autoSegmentationProgress = 0.0f;
+std::atomic<bool> autoSegmentationCancelled = false;
+// Set when the job is left for any reason, and when job is not started because painting is not loaded into the model.
+std::atomic<bool> autoSegmentationFinished = false;
+std::thread autoSegmentationThread;
 std::thread objectSelectionThread;
 
 // First value is for condition when user selecting pixels and second value is for unselecting pixels.
 std::pair<bool, bool> buttonHeld;
+// Selection that following prompts refine, it is changed only by input callbacks.
+SegmentationPrompt currentSelection {};
+uint64_t selectionCount = 0;
+std::optional<glm::dvec2> boxSelectionStart;
 
 Inpaint::CriminisiInpainter inpainter;
+// Snapshot of the inpainted painting that is written to the history folder in background.
+std::future<void> historyWrite;
 
 static Sam::Parameter getSamParam(std::string const& preprocessModel,
     std::string const& segmentModel,
@@ -57,9 +122,112 @@ static Sam::Parameter getSamParam(std::string const& preprocessModel,
 
 Sam::Parameter paramSam = getSamParam(PATH_PARAMS.PREPROCESS_SAM_MODEL_PATH, PATH_PARAMS.SAM_MODEL_PATH, 0, 0);
 
-static void loadImage(Sam* sam, std::string const& inputImage)
+/* Model is built once and kept for all paintings. Encoder and decoder are run once on blank image, so
+   the first painting and the first prompt do not pay for lazy initialization of the runtime. */
+static void buildSamModel()
+{
+    std::cout << "Starting to build Segment Anything model... " << '\n';
+    samModel = std::make_shared<Sam>(paramSam);
+    const cv::Size inputSize = samModel->getInputSize();
+    std::cout << "Building is finished!" << '\n';
+
+    if (!inputSize.empty()) {
+        cv::Mat warmUpImage = cv::Mat::zeros(inputSize, CV_8UC3);
+        samModel->setWindowResolution(inputSize.width, inputSize.height);
+        if (samModel->loadImage(warmUpImage)) {
+            samModel->getMask(cv::Point(inputSize.width / 2, inputSize.height / 2));
+        }
+        std::cout << "Segment Anything model is warmed up" << '\n';
+    }
+}
+
+/* Progress is reported between decoded points of the job on the job thread, which holds the model. Model is
+   released there while prompts of the user are decoded, so selection does not wait for the whole job. */
+static void reportAutoSegmentationProgress(double progress)
 {
-    cv::Size inputSize = sam->getInputSize();
+    autoSegmentationProgress = static_cast<float>(progress);
+    if (!segmentationPrompts.isIdle()) {
+        samModelMutex.unlock();
+        segmentationPrompts.waitUntilIdle();
+        samModelMutex.lock();
+    }
+}
+
+/* Job runs next to the interactive prompts and shares the model with them. Model has no way to stop the job,
+   so job that is cancelled when painting is destroyed runs to the end and its objects are dropped. */
+static void runAutoSegmentation()
+{
+    int objectsCount = 0;
+    cv::Mat labels;
+    {
+        std::lock_guard<std::mutex> lock(samModelMutex);
+        labels = samModel->autoSegment(cv::Size(AUTO_SEGMENTATION_GRID_SIZE, AUTO_SEGMENTATION_GRID_SIZE),
+            reportAutoSegmentationProgress, 0.86, 100, &objectsCount);
+    }
+    if (autoSegmentationCancelled) {
+        std::cout << "Automatic segmentation is cancelled" << '\n';
+        autoSegmentationFinished = true;
+        return;
+    }
+    if (labels.empty() || objectsCount == 0) {
+        std::cout << "Automatic segmentation has not found objects" << '\n';
+        autoSegmentationProgress = 1.0f;
+        autoSegmentationFinished = true;
+        return;
+    }
+
+    labels.convertTo(labels, CV_32S);
+    cv::resize(labels, labels, cv::Size(imageResolution.x, imageResolution.y), 0, 0, cv::INTER_NEAREST);
+
+    double maxLabel = 0;
+    cv::minMaxLoc(labels, nullptr, &maxLabel);
+    std::vector<glm::ivec2> boundsMin(static_cast<size_t>(maxLabel) + 1, glm::ivec2(std::numeric_limits<int32_t>::max()));
+    std::vector<glm::ivec2> boundsMax(static_cast<size_t>(maxLabel) + 1, glm::ivec2(-1));
+    for (int y = 0; y < labels.rows; y++) {
+        const int32_t* row = labels.ptr<int32_t>(y);
+        for (int x = 0; x < labels.cols; x++) {
+            if (row[x] > 0) {
+                boundsMin[row[x]] = glm::min(boundsMin[row[x]], glm::ivec2(x, y));
+                boundsMax[row[x]] = glm::max(boundsMax[row[x]], glm::ivec2(x, y));
+            }
+        }
+    }
+
+    autoSegmentation.labelBounds.assign(boundsMin.size(), cv::Rect());
+    for (size_t label = 1; label < boundsMin.size(); label++) {
+        if (boundsMax[label].x >= 0) {
+            autoSegmentation.labelBounds[label] = cv::Rect(cv::Point(boundsMin[label].x, boundsMin[label].y),
+                cv::Point(boundsMax[label].x + 1, boundsMax[label].y + 1));
+        }
+    }
+    autoSegmentation.labels = labels;
+    autoSegmentationProgress = 1.0f;
+    autoSegmentationReady = true;
+    autoSegmentationFinished = true;
+    std::cout << "Automatic segmentation has found " << objectsCount << " objects" << '\n';
+}
+
+// FNV-1a hash of the encoder input image, it is already resized to model input size.
+static uint64_t createImageKey(const cv::Mat& image)
+{
+    const uint64_t fnvPrime = 1099511628211ull;
+    uint64_t key = 14695981039346656037ull;
+    const auto hash = [&key, fnvPrime](const unsigned char* data, size_t size) {
+        for (size_t i = 0; i < size; i++) {
+            key = (key ^ data[i]) * fnvPrime;
+        }
+    };
+    const int imageDimensions[] = { image.cols, image.rows, image.type() };
+    hash(reinterpret_cast<const unsigned char*>(imageDimensions), sizeof(imageDimensions));
+    for (int row = 0; row < image.rows; row++) {
+        hash(image.ptr(row), image.cols * image.elemSize());
+    }
+    return key;
+}
+
+static void loadImage(std::string const& inputImage)
+{
+    cv::Size inputSize = samModel->getInputSize();
     std::cout << "Model resolution: " << '\n'
               << "  width: " << inputSize.width << '\n'
               << "  height: " << inputSize.height << '\n';
@@ -81,12 +249,17 @@ static void loadImage(Sam* sam, std::string const& inputImage)
               << "  width: " << image.cols << '\n'
               << "  height: " << image.rows << '\n';
 
-    sam->setWindowResolution(windowResolution.x, windowResolution.y);
+    samModel->setWindowResolution(windowResolution.x, windowResolution.y);
 
     resize(image, image, inputSize);
-    if (!sam->loadImage(image)) {
+    const uint64_t embeddingKey = createImageKey(image);
+    if (loadedEmbeddingKey == embeddingKey) {
+        std::cout << "Image is already loaded!" << '\n';
+    } else if (!samModel->loadImage(image)) {
+        loadedEmbeddingKey.reset();
         std::cout << "Image loading failed" << '\n';
     } else {
+        loadedEmbeddingKey = embeddingKey;
         std::cout << "Image is loaded!" << '\n';
     }
     
@@ -94,38 +267,197 @@ static void loadImage(Sam* sam, std::string const& inputImage)
     image = latestImageTexture;
 }
 
-cv::Mat ImageSegmantationSystem::segmentImage(const Sam* sam)
+// All points and box of the selection are decoded with single decoder run.
+cv::Mat ImageSegmantationSystem::segmentImage(const Sam* sam, const SegmentationPrompt& prompt)
 {
-    double xpos;
-    double ypos;
-    glfwGetCursorPos(pWindow.get(), &xpos, &ypos);
-    cv::Point point(xpos, ypos);
-    return sam->getMask(point);
+    if (prompt.box.empty()) {
+        return sam->getMask(prompt.points, prompt.negativePoints);
+    }
+    return sam->getMask(prompt.points, prompt.negativePoints, prompt.box);
 }
 
-static void useBrush(glm::uvec2 pos)
+static const MaskRegions::Region EMPTY_REGION { glm::uvec2(0), 0,
+    glm::uvec2(std::numeric_limits<uint32_t>::max()), glm::uvec2(0), 0 };
+
+static void markDirty(MaskRegions& mask, glm::uvec2 boundsMin, glm::uvec2 boundsMax)
 {
-    if (buttonHeld.first) {
-        std::cout << "Holding. Pixel position: " << pos.x << " " << pos.y << '\n';
-        for (glm::uvec2 brushPos : brushPositions) {
-            objectPositions[mouseControl->maskIndex].emplace(pos + brushPos, pos + brushPos);
-        }
+    mask.dirtyMin = glm::min(mask.dirtyMin, boundsMin);
+    mask.dirtyMax = glm::max(mask.dirtyMax, boundsMax);
+}
+
+static bool isDirty(const MaskRegions& mask)
+{
+    return mask.dirtyMin.x <= mask.dirtyMax.x && mask.dirtyMin.y <= mask.dirtyMax.y;
+}
+
+static void clearMaskRegions(MaskRegions& mask)
+{
+    std::fill(mask.labels.begin(), mask.labels.end(), UNSELECTED_REGION_LABEL);
+    std::fill(mask.selectedPixels.begin(), mask.selectedPixels.end(), 0);
+    mask.regions.assign(BRUSH_REGION_LABEL + 1, EMPTY_REGION);
+    mask.freeLabels.clear();
+    mask.selectedPixelCount = 0;
+    markDirty(mask, glm::uvec2(0), imageResolution - 1u);
+}
+
+// Returns unselected label when all labels are used.
+static uint16_t allocateRegion(MaskRegions& mask, glm::uvec2 seedPos)
+{
+    uint16_t label = UNSELECTED_REGION_LABEL;
+    if (!mask.freeLabels.empty()) {
+        label = mask.freeLabels.back();
+        mask.freeLabels.pop_back();
+    } else if (mask.regions.size() <= std::numeric_limits<uint16_t>::max()) {
+        label = static_cast<uint16_t>(mask.regions.size());
+        mask.regions.push_back(EMPTY_REGION);
     }
-    if (buttonHeld.second) {
-        for (glm::uvec2 brushPos : brushPositions) {
-            if (objectPositions[mouseControl->maskIndex].contains(pos + brushPos)) {
-                std::cout << "Removing selected pixel: " << pos.x << " " << pos.y
-                          << '\n';
-                objectPositions[mouseControl->maskIndex].erase(pos + brushPos);
-            }
+    if (label != UNSELECTED_REGION_LABEL) {
+        mask.regions[label] = EMPTY_REGION;
+        mask.regions[label].seedPos = seedPos;
+    }
+    return label;
+}
+
+static void releaseRegionIfEmpty(MaskRegions& mask, uint16_t label)
+{
+    if (label != BRUSH_REGION_LABEL && mask.regions[label].pixelCount == 0) {
+        mask.freeLabels.push_back(label);
+    }
+}
+
+static size_t getPixelIndex(glm::uvec2 pos)
+{
+    return static_cast<size_t>(pos.y) * imageResolution.x + pos.x;
+}
+
+// Already selected pixel keeps label of its region.
+static void selectPixel(MaskRegions& mask, glm::uvec2 pos, uint16_t label)
+{
+    const size_t pixel = getPixelIndex(pos);
+    if (mask.labels[pixel] == UNSELECTED_REGION_LABEL) {
+        MaskRegions::Region& region = mask.regions[label];
+        mask.labels[pixel] = label;
+        mask.selectedPixels[pixel] = SELECTED_REGION_HIGHLIGHT;
+        region.pixelCount++;
+        region.boundsMin = glm::min(region.boundsMin, pos);
+        region.boundsMax = glm::max(region.boundsMax, pos);
+        mask.selectedPixelCount++;
+        markDirty(mask, pos, pos);
+    }
+}
+
+// Bounds of the region are not shrinked, so region is still cleared within its bounds later.
+static void unselectPixel(MaskRegions& mask, glm::uvec2 pos)
+{
+    const size_t pixel = getPixelIndex(pos);
+    const uint16_t label = mask.labels[pixel];
+    if (label != UNSELECTED_REGION_LABEL) {
+        mask.labels[pixel] = UNSELECTED_REGION_LABEL;
+        mask.selectedPixels[pixel] = 0;
+        mask.regions[label].pixelCount--;
+        mask.selectedPixelCount--;
+        markDirty(mask, pos, pos);
+        releaseRegionIfEmpty(mask, label);
+    }
+}
+
+static void removeRegion(MaskRegions& mask, uint16_t label)
+{
+    MaskRegions::Region& region = mask.regions[label];
+    for (uint32_t y = region.boundsMin.y; y <= region.boundsMax.y; y++) {
+        const size_t rowBegin = getPixelIndex(glm::uvec2(region.boundsMin.x, y));
+        const size_t rowEnd = getPixelIndex(glm::uvec2(region.boundsMax.x, y)) + 1;
+        for (size_t pixel = rowBegin; pixel < rowEnd; pixel++) {
+            const bool inRegion = mask.labels[pixel] == label;
+            mask.labels[pixel] = inRegion ? UNSELECTED_REGION_LABEL : mask.labels[pixel];
+            mask.selectedPixels[pixel] = inRegion ? 0 : mask.selectedPixels[pixel];
         }
     }
+    markDirty(mask, region.boundsMin, region.boundsMax);
+    mask.selectedPixelCount -= region.pixelCount;
+    region.pixelCount = 0;
+    releaseRegionIfEmpty(mask, label);
+}
+
+static bool isInsideImage(glm::uvec2 pos)
+{
+    return pos.x < imageResolution.x && pos.y < imageResolution.y;
+}
+
+/* Decoded mask is thresholded at decoder resolution and only its bounding box is upscaled to the image, so
+   small object on big painting does not cost resize and scan of the whole frame. Box is grown by one decoded
+   pixel, so interpolation at its border sees unselected pixels. Returns image position of the binary mask. */
+static cv::Point upscaleDecodedMask(const cv::Mat& decodedMask, cv::Mat& binaryMask)
+{
+    cv::Mat decodedBinaryMask;
+    const cv::Rect decodedBounds = MaskIngestion::thresholdDecodedMask(decodedMask, decodedBinaryMask);
+    if (decodedBounds.empty()) {
+        binaryMask = cv::Mat();
+        return cv::Point();
+    }
+
+    const cv::Rect paddedBounds = cv::Rect(decodedBounds.tl() - cv::Point(1, 1), decodedBounds.size() + cv::Size(2, 2))
+        & cv::Rect(0, 0, decodedMask.cols, decodedMask.rows);
+    const glm::dvec2 scale = glm::dvec2(imageResolution) / glm::dvec2(decodedMask.cols, decodedMask.rows);
+    const cv::Point imageBoundsMin(static_cast<int>(paddedBounds.x * scale.x), static_cast<int>(paddedBounds.y * scale.y));
+    const cv::Point imageBoundsMax(
+        std::min(static_cast<int>(std::ceil(paddedBounds.br().x * scale.x)), static_cast<int>(imageResolution.x)),
+        std::min(static_cast<int>(std::ceil(paddedBounds.br().y * scale.y)), static_cast<int>(imageResolution.y)));
+    const cv::Rect imageBounds(imageBoundsMin, imageBoundsMax);
+
+    cv::Mat upscaledMask;
+    cv::resize(decodedMask(paddedBounds), upscaledMask, imageBounds.size());
+    cv::Mat upscaledBinaryMask;
+    const cv::Rect bounds = MaskIngestion::thresholdDecodedMask(upscaledMask, upscaledBinaryMask);
+    binaryMask = bounds.empty() ? cv::Mat() : upscaledBinaryMask(bounds);
+    return imageBounds.tl() + bounds.tl();
+}
+
+// Stamps label into unselected pixels of binary mask that is placed at the image position. Region grows by mask bounds.
+static void stampRegion(MaskRegions& mask, const cv::Mat& binaryMask, cv::Point maskPos, uint16_t label)
+{
+    if (binaryMask.empty()) {
+        return;
+    }
+
+    const uint32_t stampedPixelCount = MaskIngestion::stampLabels(binaryMask, maskPos, imageResolution.x, label,
+        mask.labels.data(), mask.selectedPixels.data());
+
+    const glm::uvec2 boundsMin = glm::uvec2(maskPos.x, maskPos.y);
+    const glm::uvec2 boundsMax = boundsMin + glm::uvec2(binaryMask.cols - 1, binaryMask.rows - 1);
+    MaskRegions::Region& region = mask.regions[label];
+    region.pixelCount += stampedPixelCount;
+    region.boundsMin = glm::min(region.boundsMin, boundsMin);
+    region.boundsMax = glm::max(region.boundsMax, boundsMax);
+    mask.selectedPixelCount += stampedPixelCount;
+    markDirty(mask, boundsMin, boundsMax);
 }
 
 inline glm::uvec2 resisePointPos(glm::vec2 pos) {
     return (pos / glm::vec2(windowResolution)) * glm::vec2(imageResolution);
 }
 
+/* Brush samples are placed along the cursor path with spacing of half the radius, so fast stroke has no gaps
+   between cursor positions. Sample unselects pixels when right button is held. Brushed pixels share one label
+   once they are read back, but they are removed one by one like separate regions. */
+static void useBrush(glm::uvec2 pos)
+{
+    const glm::vec2 brushPos = glm::vec2(pos) + 0.5f;
+    const float unselect = buttonHeld.second ? 1.0f : 0.0f;
+    if (lastBrushPos) {
+        const float spacing = std::max(brushRadius * 0.5f, 0.5f);
+        const float distance = glm::distance(*lastBrushPos, brushPos);
+        for (float step = spacing; step < distance; step += spacing) {
+            brushSamples.emplace_back(glm::mix(*lastBrushPos, brushPos, step / distance), brushRadius, unselect);
+        }
+    }
+    brushSamples.emplace_back(brushPos, brushRadius, unselect);
+    lastBrushPos = brushPos;
+    if (!brushInputTime) {
+        brushInputTime = SelectionLatency::Clock::now();
+    }
+}
+
 static void cursor_position_callback(GLFWwindow* window, double xpos, double ypos)
 {
     if (buttonHeld.first || buttonHeld.second) {
@@ -134,19 +466,108 @@ static void cursor_position_callback(GLFWwindow* window, double xpos, double ypo
     }
 }
 
+// Object that contains position is selected by its label, returns false when there is no object.
+static bool selectAutoSegmentedObject(glm::uvec2 pos)
+{
+    if (!autoSegmentationReady || !isInsideImage(pos)) {
+        return false;
+    }
+    const int32_t objectLabel = autoSegmentation.labels.at<int32_t>(pos.y, pos.x);
+    if (objectLabel <= 0) {
+        return false;
+    }
+    const SelectionLatency::Clock::time_point inputTime = SelectionLatency::Clock::now();
+
+    std::lock_guard<std::mutex> lock(maskRegionsMutex);
+    MaskRegions& mask = objectPositions[currentSelection.maskIndex];
+    const uint16_t label = allocateRegion(mask, pos);
+    if (label == UNSELECTED_REGION_LABEL) {
+        return false;
+    }
+    mask.regions[label].selectionId = currentSelection.selectionId;
+
+    const cv::Rect& bounds = autoSegmentation.labelBounds[objectLabel];
+    for (int y = bounds.y; y < bounds.y + bounds.height; y++) {
+        const int32_t* row = autoSegmentation.labels.ptr<int32_t>(y);
+        for (int x = bounds.x; x < bounds.x + bounds.width; x++) {
+            if (row[x] == objectLabel) {
+                selectPixel(mask, glm::uvec2(x, y), label);
+            }
+        }
+    }
+    releaseRegionIfEmpty(mask, label);
+
+    // Object is kept for inpainting as decoded mask of the last selection, it is already at image resolution.
+    decodedPosMask = cv::Mat::zeros(autoSegmentation.labels.size(), CV_8UC1);
+    cv::Mat objectMask = decodedPosMask(bounds);
+    cv::compare(autoSegmentation.labels(bounds), objectLabel, objectMask, cv::CMP_EQ);
+    image = latestImageTexture.clone();
+    selectionLatency.record(SelectionLatency::MASK_INGESTION, inputTime);
+    selectionLatency.selectionIngested(inputTime);
+    std::cout << "Object is selected by automatic segmentation label " << objectLabel << '\n';
+    return true;
+}
+
+/* Drag that is long enough selects with box, otherwise selection starts with point where button was pressed.
+   Point on the object that is found by automatic segmentation selects it without running the decoder, the
+   selection can be refined with prompts later. */
+static void startSelection(glm::dvec2 startPos, glm::dvec2 endPos)
+{
+    currentSelection = SegmentationPrompt {};
+    currentSelection.maskIndex = mouseControl->maskIndex;
+    currentSelection.selectionId = ++selectionCount;
+
+    const glm::dvec2 boxMin = glm::min(startPos, endPos);
+    const glm::dvec2 boxSize = glm::abs(endPos - startPos);
+    if (boxSize.x >= SELECTION_BOX_MIN_SIZE && boxSize.y >= SELECTION_BOX_MIN_SIZE) {
+        currentSelection.box = cv::Rect(boxMin.x, boxMin.y, boxSize.x, boxSize.y);
+        currentSelection.imagePos = resisePointPos((startPos + endPos) * 0.5);
+    } else {
+        currentSelection.points.emplace_back(startPos.x, startPos.y);
+        currentSelection.imagePos = resisePointPos(startPos);
+        if (selectAutoSegmentedObject(currentSelection.imagePos)) {
+            return;
+        }
+    }
+    segmentationPrompts.push(currentSelection);
+}
+
+// Positive point starts new selection when there is no selection of the current mask to refine.
+static void refineSelection(glm::dvec2 cursorPos, bool negative)
+{
+    if (currentSelection.selectionId == 0 || currentSelection.maskIndex != mouseControl->maskIndex) {
+        if (!negative) {
+            startSelection(cursorPos, cursorPos);
+        }
+        return;
+    }
+
+    std::list<cv::Point>& points = negative ? currentSelection.negativePoints : currentSelection.points;
+    points.emplace_back(cursorPos.x, cursorPos.y);
+    segmentationPrompts.push(currentSelection);
+}
+
+/* Control with left button selects region with point or with box when it is dragged. Shift and alt with it
+   add positive and negative point to the last selection, and its region is selected again. */
 static void mouse_buttons_callback(GLFWwindow* window, int button, int action,
     int mods)
 {
     if (imageLoaded) {
         if (button == GLFW_MOUSE_BUTTON_LEFT && action == GLFW_RELEASE) {
-            currentSelectedObjectsSize[mouseControl->maskIndex] = objectPositions[mouseControl->maskIndex].size();
             buttonHeld.first = false;
+            lastBrushPos.reset();
+            if (boxSelectionStart) {
+                glm::dvec2 cursorPos {};
+                glfwGetCursorPos(window, &cursorPos.x, &cursorPos.y);
+                startSelection(*boxSelectionStart, cursorPos);
+                boxSelectionStart.reset();
+            }
         }
         if (button == GLFW_MOUSE_BUTTON_RIGHT && action == GLFW_RELEASE) {
-            currentSelectedObjectsSize[mouseControl->maskIndex] = objectPositions[mouseControl->maskIndex].size();
             buttonHeld.second = false;
+            lastBrushPos.reset();
         }
-        if (button == GLFW_MOUSE_BUTTON_LEFT && action == GLFW_PRESS && mods == GLFW_MOD_CONTROL) {
+        if (button == GLFW_MOUSE_BUTTON_LEFT && action == GLFW_PRESS && (mods & GLFW_MOD_CONTROL)) {
             glm::dvec2 cursorPos {};
             glfwGetCursorPos(window, &cursorPos.x, &cursorPos.y);
             glm::uvec2 pos = resisePointPos(cursorPos);
@@ -154,8 +575,10 @@ static void mouse_buttons_callback(GLFWwindow* window, int button, int action,
             if (mouseControl->pixelScaling) {
                 buttonHeld.first = true;
                 useBrush(pos);
+            } else if (mods & (GLFW_MOD_SHIFT | GLFW_MOD_ALT)) {
+                refineSelection(cursorPos, mods & GLFW_MOD_ALT);
             } else {
-                inputPositions.push(pos);
+                boxSelectionStart = cursorPos;
             }
         }
         if (button == GLFW_MOUSE_BUTTON_RIGHT && action == GLFW_PRESS && mods == GLFW_MOD_CONTROL) {
@@ -167,14 +590,16 @@ static void mouse_buttons_callback(GLFWwindow* window, int button, int action,
                 buttonHeld.second = true;
                 useBrush(pos);
             } else {
-                if (objectPositions[mouseControl->maskIndex].contains(pos)) {
+                std::lock_guard<std::mutex> lock(maskRegionsMutex);
+                MaskRegions& mask = objectPositions[mouseControl->maskIndex];
+                const uint16_t label = isInsideImage(pos) ? mask.labels[getPixelIndex(pos)] : UNSELECTED_REGION_LABEL;
+                if (label != UNSELECTED_REGION_LABEL) {
                     std::cout << "Removing region that contains pixel: " << pos.x << " " << pos.y << '\n';
-                    glm::uvec2 pressedKeyPos = objectPositions[mouseControl->maskIndex].at(pos);
-                    std::erase_if(objectPositions[mouseControl->maskIndex],
-                        [&](const std::pair<glm::uvec2, glm::uvec2>& entry) {
-                            return entry.second == pressedKeyPos;
-                        });
-                    currentSelectedObjectsSize[mouseControl->maskIndex] = objectPositions[mouseControl->maskIndex].size();
+                    if (label == BRUSH_REGION_LABEL) {
+                        unselectPixel(mask, pos);
+                    } else {
+                        removeRegion(mask, label);
+                    }
                 }
             }
         }
@@ -183,56 +608,101 @@ static void mouse_buttons_callback(GLFWwindow* window, int button, int action,
 
 void ImageSegmantationSystem::runObjectSegmentationTask()
 {
-    std::cout << "Starting to build Segment Anything model... " << '\n';
-    samModel = std::make_unique<Sam>(paramSam);
-    std::cout << "Building is finished!" << '\n';
-
-    loadImage(samModel.get(), imagePath);
+    {
+        // Model of the painting is switched by loading, while window resolution can be changed by the render thread.
+        std::lock_guard<std::mutex> lock(samModelMutex);
+        std::call_once(samModelBuilt, buildSamModel);
+        loadImage(imagePath);
+    }
+    if (loadedEmbeddingKey) {
+        autoSegmentationThread = std::thread(runAutoSegmentation);
+    } else {
+        autoSegmentationFinished = true;
+    }
     imageLoaded = true;
+    decodePrompts();
+}
 
-    while (runningSegmentation) {
-        bool inputPositionsEmpty = inputPositions.empty();
-        if (!inputPositionsEmpty) {
-            glm::uvec2 pos = inputPositions.front();
-            inputPositions.pop();
-
-            selectedPosMask = segmentImage(samModel.get());
-            image = latestImageTexture.clone();
-   
-            cv::resize(selectedPosMask, selectedPosMask, cv::Size(imageResolution.x, imageResolution.y));
-            auto pResisedMaskPixels = static_cast<uint8_t*>(selectedPosMask.data);
-
-            for (uint32_t height = 0; height < imageResolution.y; height++) {
-                for (uint32_t width = 0; width < imageResolution.x; width++) {
-                    uint8_t red = pResisedMaskPixels[height * selectedPosMask.cols + width + 2];
-                    uint8_t green = pResisedMaskPixels[height * selectedPosMask.cols + width + 1];
-                    uint8_t blue = pResisedMaskPixels[height * selectedPosMask.cols + width];
-                    if (red == 255 && green == 255 && blue == 255) {
-                        objectPositions[mouseControl->maskIndex].emplace(glm::ivec2(width, height), pos);
-                    }
-                }
-            }
+/* Model has single decoder session, so prompts of all masks are decoded one by one on the segmentation thread.
+   Thread sleeps until prompt is pushed and leaves when queue is closed on destroy. */
+void ImageSegmantationSystem::decodePrompts()
+{
+    while (std::optional<SegmentationPrompt> prompt = segmentationPrompts.waitAndPop()) {
+        const SelectionLatency::Clock::time_point popTime = SelectionLatency::Clock::now();
+        selectionLatency.record(SelectionLatency::PROMPT_ENQUEUE, prompt->pushTime, popTime);
+        cv::Mat promptMask;
+        {
+            std::lock_guard<std::mutex> lock(samModelMutex);
+            promptMask = segmentImage(samModel.get(), *prompt);
+        }
+        selectionLatency.record(SelectionLatency::SAM_DECODE, popTime);
+        if (segmentationPrompts.isSuperseded(*prompt)) {
+            std::cout << "Selection is discarded, newer position is selected" << '\n';
+        } else {
+            selectDecodedRegion(*prompt, promptMask);
+        }
+        segmentationPrompts.finish();
+    }
+}
+
+// Decoded mask of the last selection of any mask is kept for inpainting.
+void ImageSegmantationSystem::selectDecodedRegion(const SegmentationPrompt& prompt, const cv::Mat& promptMask)
+{
+    const SelectionLatency::Clock::time_point ingestionTime = SelectionLatency::Clock::now();
+    cv::Mat binaryMask;
+    const cv::Point maskPos = upscaleDecodedMask(promptMask, binaryMask);
+
+    std::lock_guard<std::mutex> lock(maskRegionsMutex);
+    decodedPosMask = promptMask;
+    image = latestImageTexture.clone();
 
-            std::cout << "objects selected " << '\n';
-            currentSelectedObjectsSize[mouseControl->maskIndex] = objectPositions[mouseControl->maskIndex].size();
+    MaskRegions& mask = objectPositions[prompt.maskIndex];
+    // Refined selection replaces region that was selected by its previous prompts.
+    for (size_t label = BRUSH_REGION_LABEL + 1; label < mask.regions.size(); label++) {
+        if (mask.regions[label].selectionId == prompt.selectionId && mask.regions[label].pixelCount > 0) {
+            removeRegion(mask, static_cast<uint16_t>(label));
         }
     }
+    const uint16_t label = allocateRegion(mask, prompt.imagePos);
+    if (label == UNSELECTED_REGION_LABEL) {
+        std::cout << "Region is not selected, all region labels of the mask are used" << '\n';
+        return;
+    }
+    mask.regions[label].selectionId = prompt.selectionId;
+    stampRegion(mask, binaryMask, maskPos, label);
+    releaseRegionIfEmpty(mask, label);
+    selectionLatency.record(SelectionLatency::MASK_INGESTION, ingestionTime);
+    selectionLatency.selectionIngested(prompt.pushTime);
+
+    std::cout << "objects selected " << '\n';
 }
 
 void ImageSegmantationSystem::init(Device& _device, VkCommandPool& _commandPool,
     GLFWwindow* _pWindow, const std::string& _imagePath,
     uint32_t imageWidth, uint32_t imageHeight,
-    Controls::MouseControl* _mouseControl)
+    uint16_t masksCount, Controls::MouseControl* _mouseControl)
 {
+    if (masksCount > MAX_MASKS_COUNT) {
+        throw std::runtime_error("Failed to create packed mask, masks count exceeds texel bit width.");
+    }
+
     const std::string createFolder = "mkdir " + INPAINTING_HISTORY_FOLDER_NAME;
     system(createFolder.c_str());
 
     const glm::uvec2 windowSize = glm::uvec2(WINDOW_WIDTH, WINDOW_HEIGHT);
     imageResolution = glm::uvec2(imageWidth, imageHeight);
-    selectedPosMasks = std::array<Image, MASKS_COUNT>();
+    packedSelectedPosMask = Image();
+    objectPositions.resize(masksCount);
+    for (MaskRegions& mask : objectPositions) {
+        mask.labels.resize(static_cast<size_t>(imageWidth) * imageHeight);
+        mask.selectedPixels.resize(static_cast<size_t>(imageWidth) * imageHeight);
+        clearMaskRegions(mask);
+    }
     pWindow.reset(_pWindow);
     windowResolution = windowSize;
     imagePath = _imagePath;
+    currentSelection = SegmentationPrompt {};
+    boxSelectionStart.reset();
     mouseControl.reset(_mouseControl);
     device = _device.get();
     physicalDevice = _device.getPhysicalDevice();
@@ -241,17 +711,20 @@ void ImageSegmantationSystem::init(Device& _device, VkCommandPool& _commandPool,
     std::cout << "___ Initialization Phase ___ " << '\n';
     std::cout << "Threads: " << THREAD_NUMBER << '\n';
 
-    for (uint16_t maskIndex = 0; maskIndex < MASKS_COUNT; maskIndex++) {
-        selectedPosMasks[maskIndex].imageDetails.createImageInfo(
-            "", imageWidth, imageHeight, 1,
-            VK_IMAGE_LAYOUT_GENERAL,
-            VK_IMAGE_VIEW_TYPE_2D,
-            BUMP_TEXTURE_FORMAT, VK_SHADER_STAGE_FRAGMENT_BIT,
-            VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_ASPECT_COLOR_BIT, VK_SAMPLE_COUNT_1_BIT);
-        selectedPosMasks[maskIndex].create(device, physicalDevice, _commandPool,
-                                     VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
-                                     VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, transferQueue);
-    }
+    /* Masks are packed as bit planes into single unsigned integer texel, so shader can read every mask of
+       the pixel with one fetch. Texel is 32 bits wide for any masks count, as brush is stamped into it with
+       image atomics that are only supported for 32-bit formats. */
+    packedMaskTexels.assign(static_cast<size_t>(imageWidth) * imageHeight * sizeof(uint32_t), 0);
+    packedSelectedPosMask.imageDetails.createImageInfo(
+        "", imageWidth, imageHeight, sizeof(uint32_t),
+        VK_IMAGE_LAYOUT_GENERAL,
+        VK_IMAGE_VIEW_TYPE_2D,
+        VK_FORMAT_R32_UINT, VK_SHADER_STAGE_FRAGMENT_BIT | VK_SHADER_STAGE_COMPUTE_BIT,
+        VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_ASPECT_COLOR_BIT, VK_SAMPLE_COUNT_1_BIT);
+    packedSelectedPosMask.create(device, physicalDevice, _commandPool,
+                                 VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT
+                                     | VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_STORAGE_BIT,
+                                 VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, transferQueue);
 
     if (!callbackIsSet) {
         glfwSetMouseButtonCallback(pWindow.get(), mouse_buttons_callback);
@@ -264,53 +737,244 @@ void ImageSegmantationSystem::init(Device& _device, VkCommandPool& _commandPool,
 
 void ImageSegmantationSystem::destroy()
 {
-    runningSegmentation = false;
+    segmentationPrompts.close();
+    autoSegmentationCancelled = true;
     imageLoaded = false;
     if (objectSelectionThread.joinable()) {
         objectSelectionThread.join();
     }
-    for (uint16_t maskIndex = 0; maskIndex < MASKS_COUNT; maskIndex++) {
-        selectedPosMasks[maskIndex].destroy();
+    // Started by the segmentation thread, so it is joined after that thread is finished.
+    if (autoSegmentationThread.joinable()) {
+        if (!autoSegmentationFinished) {
+            std::cout << "Waiting for cancelled automatic segmentation to finish" << '\n';
+        }
+        autoSegmentationThread.join();
+    }
+    autoSegmentationCancelled = false;
+    if (historyWrite.valid()) {
+        historyWrite.wait();
     }
-    runningSegmentation = true;
+    autoSegmentationReady = false;
+    autoSegmentationFinished = false;
+    autoSegmentationProgress = 0.0f;
+    autoSegmentation = AutoSegmentation {};
+    packedSelectedPosMask.destroy();
+    packedMaskTexels.clear();
+    brushSamples.clear();
+    lastBrushPos.reset();
+    brushStampedMin = glm::uvec2(std::numeric_limits<uint32_t>::max());
+    brushStampedMax = glm::uvec2(0);
+    brushInputTime.reset();
+    segmentationPrompts.reopen();
     latestImageTexture.release();
     image.release();
-    selectedPosMask.release();
+    decodedPosMask.release();
 }
 
 void ImageSegmantationSystem::changeWindowResolution(glm::uvec2& _windowResolution)
 {
     windowResolution = _windowResolution;
+    std::lock_guard<std::mutex> lock(samModelMutex);
     samModel->setWindowResolution(windowResolution.x, windowResolution.y);
 }
 
-void ImageSegmantationSystem::removeAllMaskPositions() { objectPositions[mouseControl->maskIndex].clear(); }
+void ImageSegmantationSystem::removeAllMaskPositions()
+{
+    removeAllMaskPositions(mouseControl->maskIndex);
+}
 
 void ImageSegmantationSystem::removeAllMaskPositions(uint16_t maskIndex)
 {
-    objectPositions[maskIndex].clear();
+    std::lock_guard<std::mutex> lock(maskRegionsMutex);
+    clearMaskRegions(objectPositions[maskIndex]);
 }
 
-bool ImageSegmantationSystem::selectedObjectSizeChanged()
+void ImageSegmantationSystem::setBrushParams(float radius, float hardness)
 {
-    return selectedObjectSizeChanged(mouseControl->maskIndex);
+    brushRadius = radius;
+    brushHardness = hardness;
 }
 
-bool ImageSegmantationSystem::selectedObjectSizeChanged(uint16_t maskIndex)
+/* Method takes recorded brush samples that fit into one dispatch, the rest are taken with next frames. Stroke
+   covers texels within radius of its samples and these texels are read back later with brush strokes sync. */
+Controls::BrushStroke ImageSegmantationSystem::takeBrushStroke()
 {
-    if (selectedObjectsSize[maskIndex] != currentSelectedObjectsSize[maskIndex]) {
-        selectedObjectsSize[maskIndex] = currentSelectedObjectsSize[maskIndex];
-        return true;
+    Controls::BrushStroke brushStroke {};
+    const size_t sampleCount = std::min(brushSamples.size(), MAX_BRUSH_SAMPLES);
+    if (sampleCount == 0) {
+        return brushStroke;
+    }
+
+    glm::vec2 boundsMin = glm::vec2(std::numeric_limits<float>::max());
+    glm::vec2 boundsMax = glm::vec2(std::numeric_limits<float>::lowest());
+    for (size_t i = 0; i < sampleCount; i++) {
+        const glm::vec4& brushSample = brushSamples[i];
+        brushStroke.samples[i] = brushSample;
+        boundsMin = glm::min(boundsMin, glm::vec2(brushSample.x, brushSample.y) - brushSample.z);
+        boundsMax = glm::max(boundsMax, glm::vec2(brushSample.x, brushSample.y) + brushSample.z);
+    }
+    brushSamples.erase(brushSamples.begin(), brushSamples.begin() + sampleCount);
+    const std::optional<SelectionLatency::Clock::time_point> strokeInputTime = brushInputTime;
+    if (brushSamples.empty()) {
+        brushInputTime.reset();
+    }
+
+    const glm::ivec2 texelMin = glm::max(glm::ivec2(glm::floor(boundsMin)), glm::ivec2(0));
+    const glm::ivec2 texelMax = glm::min(glm::ivec2(glm::ceil(boundsMax)), glm::ivec2(imageResolution) - 1);
+    if (texelMin.x > texelMax.x || texelMin.y > texelMax.y) {
+        return Controls::BrushStroke {};
+    }
+    if (strokeInputTime) {
+        selectionLatency.brushStamped(*strokeInputTime);
     }
 
-    return false;
+    brushStroke.boundsMin = texelMin;
+    brushStroke.boundsSize = glm::uvec2(texelMax - texelMin + 1);
+    brushStroke.sampleCount = static_cast<uint32_t>(sampleCount);
+    brushStroke.maskBit = 1u << mouseControl->maskIndex;
+    brushStroke.hardness = brushHardness;
+    brushStampedMin = glm::min(brushStampedMin, glm::uvec2(texelMin));
+    brushStampedMax = glm::max(brushStampedMax, glm::uvec2(texelMax));
+    return brushStroke;
 }
 
+/* Texels stamped by brush are read back and their difference with the last uploaded texels is applied to masks,
+   so regions, inpainting and constructed objects see brushed pixels. GPU must not use the mask while it is read. */
+void ImageSegmantationSystem::syncBrushStrokes(Queue& transferQueue)
+{
+    if (brushStampedMin.x > brushStampedMax.x || brushStampedMin.y > brushStampedMax.y) {
+        return;
+    }
+
+    const VkOffset2D offset = { static_cast<int32_t>(brushStampedMin.x), static_cast<int32_t>(brushStampedMin.y) };
+    const VkExtent2D extent = { brushStampedMax.x - brushStampedMin.x + 1, brushStampedMax.y - brushStampedMin.y + 1 };
+    std::vector<uint8_t> stampedTexels;
+    packedSelectedPosMask.copyImageRegionToBuffer(transferQueue, offset, extent, stampedTexels);
+
+    std::lock_guard<std::mutex> lock(maskRegionsMutex);
+    const uint32_t* stampedMasks = reinterpret_cast<const uint32_t*>(stampedTexels.data());
+    uint32_t* uploadedMasks = reinterpret_cast<uint32_t*>(packedMaskTexels.data());
+    for (uint32_t y = 0; y < extent.height; y++) {
+        for (uint32_t x = 0; x < extent.width; x++) {
+            const glm::uvec2 pos = brushStampedMin + glm::uvec2(x, y);
+            const size_t pixel = getPixelIndex(pos);
+            const uint32_t stampedMask = stampedMasks[static_cast<size_t>(y) * extent.width + x];
+            for (uint32_t changedBits = stampedMask ^ uploadedMasks[pixel]; changedBits != 0; changedBits &= changedBits - 1) {
+                const uint16_t maskIndex = static_cast<uint16_t>(std::countr_zero(changedBits));
+                if (stampedMask & (1u << maskIndex)) {
+                    selectPixel(objectPositions[maskIndex], pos, BRUSH_REGION_LABEL);
+                } else {
+                    unselectPixel(objectPositions[maskIndex], pos);
+                }
+            }
+            uploadedMasks[pixel] = stampedMask;
+        }
+    }
+    brushStampedMin = glm::uvec2(std::numeric_limits<uint32_t>::max());
+    brushStampedMax = glm::uvec2(0);
+}
+
+/* Only rectangle that contains changes of all masks is packed and uploaded. Brush strokes are synced first,
+   so upload does not overwrite texels that brush stamped. */
 void ImageSegmantationSystem::updatePositionMasks(Device& device, VkCommandPool& commandPool, Queue& transferQueue)
 {
-    if (selectedObjectSizeChanged()) {
-        std::shared_ptr<uchar> spSelectedPosMask = getSelectedPositionsMask();
-        selectedPosMasks[mouseControl->maskIndex].copyBufferToImage(transferQueue, spSelectedPosMask.get());
+    syncBrushStrokes(transferQueue);
+    std::lock_guard<std::mutex> lock(maskRegionsMutex);
+    const SelectionLatency::Clock::time_point buildTime = SelectionLatency::Clock::now();
+    glm::uvec2 uploadMin = glm::uvec2(std::numeric_limits<uint32_t>::max());
+    glm::uvec2 uploadMax = glm::uvec2(0);
+    for (uint16_t maskIndex = 0; maskIndex < objectPositions.size(); maskIndex++) {
+        MaskRegions& mask = objectPositions[maskIndex];
+        if (isDirty(mask)) {
+            packMaskPlane(maskIndex, mask.dirtyMin, mask.dirtyMax);
+            uploadMin = glm::min(uploadMin, mask.dirtyMin);
+            uploadMax = glm::max(uploadMax, mask.dirtyMax);
+            mask.dirtyMin = glm::uvec2(std::numeric_limits<uint32_t>::max());
+            mask.dirtyMax = glm::uvec2(0);
+        }
+    }
+
+    if (uploadMin.x <= uploadMax.x && uploadMin.y <= uploadMax.y) {
+        const SelectionLatency::Clock::time_point uploadTime = SelectionLatency::Clock::now();
+        selectionLatency.record(SelectionLatency::MASK_BUILD, buildTime, uploadTime);
+        const VkOffset2D offset = { static_cast<int32_t>(uploadMin.x), static_cast<int32_t>(uploadMin.y) };
+        const VkExtent2D extent = { uploadMax.x - uploadMin.x + 1, uploadMax.y - uploadMin.y + 1 };
+        packedSelectedPosMask.copyBufferRegionToImage(transferQueue, packedMaskTexels.data(), offset, extent);
+        selectionLatency.record(SelectionLatency::GPU_UPLOAD, uploadTime);
+    }
+    selectionLatency.masksUploaded();
+}
+
+SelectionLatency& ImageSegmantationSystem::getSelectionLatency()
+{
+    return selectionLatency;
+}
+
+// Selection is settled when its prompts are decoded and frame that shows it is presented.
+bool ImageSegmantationSystem::isSelectionSettled()
+{
+    return segmentationPrompts.isIdle() && brushSamples.empty() && !selectionLatency.hasPendingSelections();
+}
+
+/* Scripted input is replayed as the same gestures that input callbacks handle, positions are in window
+   coordinates. Brush stroke is pressed at start position, moved to end position and released. */
+void ImageSegmantationSystem::replayInput(const ScriptedInput& input)
+{
+    switch (input.type) {
+    case ScriptedInput::POINT:
+        startSelection(input.startPos, input.startPos);
+        break;
+    case ScriptedInput::BOX:
+        startSelection(input.startPos, input.endPos);
+        break;
+    case ScriptedInput::POSITIVE_POINT:
+        refineSelection(input.startPos, false);
+        break;
+    case ScriptedInput::NEGATIVE_POINT:
+        refineSelection(input.startPos, true);
+        break;
+    case ScriptedInput::BRUSH:
+    case ScriptedInput::UNSELECT_BRUSH:
+        buttonHeld = { input.type == ScriptedInput::BRUSH, input.type == ScriptedInput::UNSELECT_BRUSH };
+        useBrush(resisePointPos(input.startPos));
+        useBrush(resisePointPos(input.endPos));
+        buttonHeld = { false, false };
+        lastBrushPos.reset();
+        break;
+    }
+}
+
+/* Method writes selected pixels of the mask within rectangle into its bit plane of the packed texels. Texels
+   are little-endian, so mask bit is found in the byte maskIndex / 8 of the texel for any texel size. */
+void ImageSegmantationSystem::packMaskPlane(uint16_t maskIndex, glm::uvec2 boundsMin, glm::uvec2 boundsMax)
+{
+    const std::vector<uchar>& selectedPixels = objectPositions[maskIndex].selectedPixels;
+    const uint8_t texelSize = packedSelectedPosMask.getDetails().channels;
+    const uint8_t maskByte = maskIndex / 8;
+    const uint8_t maskBit = 1 << (maskIndex % 8);
+    for (uint32_t y = boundsMin.y; y <= boundsMax.y; y++) {
+        const size_t rowBegin = getPixelIndex(glm::uvec2(boundsMin.x, y));
+        const size_t rowEnd = getPixelIndex(glm::uvec2(boundsMax.x, y)) + 1;
+        for (size_t pixel = rowBegin; pixel < rowEnd; pixel++) {
+            uint8_t& texelByte = packedMaskTexels[pixel * texelSize + maskByte];
+            if (selectedPixels[pixel] != 0) {
+                texelByte |= maskBit;
+            } else {
+                texelByte &= ~maskBit;
+            }
+        }
+    }
+}
+
+static void writeInpaintingHistory(cv::Mat inpaintedImage)
+{
+    std::stringstream filePath;
+    filePath << INPAINTING_HISTORY_FOLDER_NAME << "/" << "latest.png";
+    std::vector<int> imageWriteParams;
+    imageWriteParams.push_back(cv::IMWRITE_PNG_COMPRESSION);
+    imageWriteParams.push_back(0);
+    if (!cv::imwrite(filePath.str(), inpaintedImage, imageWriteParams)) {
+        std::cout << "Inpainted image is not written to the history" << '\n';
     }
 }
 
@@ -319,8 +983,18 @@ void ImageSegmantationSystem::updatePositionMasks(Device& device, VkCommandPool&
    found using moments of pixel colors of the image that is used to align inpainted area to the center.
    To inpaint the image there will be used square area patch of the image instead of whole image to 
    speed up method excecution time for larger images.  */
-void ImageSegmantationSystem::inpaintImage(uint8_t patchSize, std::vector<Image>& objectsTextures, Descriptor& descriptor, VkCommandPool& commandPool, Queue& transferQueue)
+void ImageSegmantationSystem::inpaintImage(uint8_t patchSize, std::vector<Image>& objectsTextures, VkCommandPool& commandPool, Queue& transferQueue)
 {
+    cv::Mat selectedPosMask;
+    {
+        // Decoded mask is replaced by the segmentation thread and by selection of automatically segmented object.
+        std::lock_guard<std::mutex> lock(maskRegionsMutex);
+        if (decodedPosMask.empty()) {
+            std::cout << "Nothing is inpainted, no object is selected" << '\n';
+            return;
+        }
+        cv::resize(decodedPosMask, selectedPosMask, cv::Size(imageResolution.x, imageResolution.y));
+    }
     std::vector<std::vector<cv::Point>> contours;
     cv::findContours(selectedPosMask, contours, cv::RETR_TREE, cv::CHAIN_APPROX_SIMPLE);
     uint32_t biggestArea = 0;
@@ -365,18 +1039,22 @@ void ImageSegmantationSystem::inpaintImage(uint8_t patchSize, std::vector<Image>
     cv::copyMakeBorder(inpaintedImage, resImage, top, bottom, left, right, cv::BorderTypes::BORDER_CONSTANT, 0);
     cv::copyTo(resImage, image, selectedPosMask);
 
-    std::stringstream filePath;
-    filePath << INPAINTING_HISTORY_FOLDER_NAME << "/" << "latest.png";
-    std::vector<int> imageWriteParams;
-    imageWriteParams.push_back(cv::IMWRITE_PNG_COMPRESSION);
-    imageWriteParams.push_back(0);
-    cv::imwrite(filePath.str(), image, imageWriteParams);
     latestImageTexture = image.clone();
     std::cout << "Background is inpainted" << '\n';
 
+    // Previous snapshot is finished first, so snapshots are written in order and do not pile up.
+    if (historyWrite.valid()) {
+        historyWrite.wait();
+    }
+    historyWrite = std::async(std::launch::async, writeInpaintingHistory, latestImageTexture.clone());
+
+    // Texture is uploaded from memory in the channel order that textures are loaded with.
+    cv::Mat inpaintedTexture;
+    const int colorConversion = image.channels() == 4 ? cv::COLOR_BGRA2RGBA
+        : image.channels() == 3 ? cv::COLOR_BGR2RGBA : cv::COLOR_GRAY2RGBA;
+    cv::cvtColor(image, inpaintedTexture, colorConversion);
+
     Image::Details imageDetails = objectsTextures.front().getDetails();
-    int w, h, channels;
-    uchar* inpaintedTextureBuffer = stbi_load(filePath.str().c_str(), &w, &h, &channels, STBI_rgb_alpha);
     Image inpaintImage;
     inpaintImage.imageDetails.createImageInfo(
         "", imageDetails.width, imageDetails.height, imageDetails.channels,
@@ -384,49 +1062,34 @@ void ImageSegmantationSystem::inpaintImage(uint8_t patchSize, std::vector<Image>
         IMAGE_TEXTURE_FORMAT,
         VK_SHADER_STAGE_FRAGMENT_BIT | VK_SHADER_STAGE_COMPUTE_BIT,
         VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_ASPECT_COLOR_BIT,
-        VK_SAMPLE_COUNT_1_BIT, inpaintedTextureBuffer, imageDetails.bindingId);
+        VK_SAMPLE_COUNT_1_BIT, inpaintedTexture.data);
     inpaintImage.create(this->device, physicalDevice, commandPool,
         VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
         VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, transferQueue);
-    stbi_image_free(inpaintedTextureBuffer);
     objectsTextures.push_back(inpaintImage);
-
-    uint16_t maxBinding = Image::bindingIdToImageArrayElementId[imageDetails.bindingId];
-    descriptor.updateBindlessTexture(objectsTextures.back(), 0);
-    uint16_t arrayElementId = 1;
-    for (uint16_t i = maxBinding; i >= 1; i--) {
-        descriptor.updateBindlessTexture(objectsTextures[maxBinding - i], arrayElementId++);
-    }
 }
 
 bool& ImageSegmantationSystem::isImageLoaded() { return imageLoaded; }
 
-const std::shared_ptr<uchar> ImageSegmantationSystem::getSelectedPositionsMask()
+float ImageSegmantationSystem::getAutoSegmentationProgress() { return autoSegmentationProgress; }
+
+bool ImageSegmantationSystem::isAutoSegmentationFinished() { return autoSegmentationFinished; }
+
+bool ImageSegmantationSystem::isImageEmbeddingLoaded() { return loadedEmbeddingKey.has_value(); }
+
+void ImageSegmantationSystem::withSelectedPositionsMask(const std::function<void(const uchar*)>& useMask)
 {
-    return getSelectedPositionsMask(mouseControl->maskIndex);
+    withSelectedPositionsMask(mouseControl->maskIndex, useMask);
 }
 
-const std::shared_ptr<uchar> ImageSegmantationSystem::getSelectedPositionsMask(uint16_t maskIndex)
+// Lock is held for the whole callback, because the decoder thread writes selected pixels.
+void ImageSegmantationSystem::withSelectedPositionsMask(uint16_t maskIndex, const std::function<void(const uchar*)>& useMask)
 {
-   std::shared_ptr<uchar> spPositionMask;
-   auto pixelSize = static_cast<size_t>(imageResolution.x) * static_cast<size_t>(imageResolution.y);
-   auto pSelectedPositionsMask = static_cast<unsigned char*>(calloc(1, pixelSize));
-    for (uint32_t width = 0; width < imageResolution.x; width++) {
-        for (uint32_t height = 0; height < imageResolution.y; height++) {
-            unsigned char* offset = pSelectedPositionsMask + width + (imageResolution.x * height);
-            auto pos = glm::uvec2(width, height);
-            if (objectPositions[maskIndex].contains(pos)) {
-                offset[0] = SELECTED_REGION_HIGHLIGHT;
-            } else {
-                offset[0] = 0;
-            }
-        }
-    }
-    spPositionMask.reset(pSelectedPositionsMask);
-    return spPositionMask;
+    std::lock_guard<std::mutex> lock(maskRegionsMutex);
+    useMask(objectPositions[maskIndex].selectedPixels.data());
 }
 
-const std::array<Image, MASKS_COUNT>& ImageSegmantationSystem::getSelectedPosMasks()
+const Image& ImageSegmantationSystem::getSelectedPosMask()
 {
-    return selectedPosMasks;
+    return packedSelectedPosMask;
 }
\ No newline at end of file
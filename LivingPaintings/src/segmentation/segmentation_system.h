@@ -1,50 +1,77 @@
 #pragma once
 #include "inpaint/criminisi_inpainter.h"
+#include "mask_ingestion.h"
+#include "prompt_queue.h"
+#include "selection_latency.h"
 #include "../include/sam/sam.h"
 #include "../vulkan/controls.h"
 #include "../vulkan/image.h"
 #include "../vulkan/consts.h"
-#include "../vulkan/descriptor.h"
 #include "glm/glm.hpp"
 #include "glm/gtx/hash.hpp"
+#include <atomic>
+#include <bit>
 #include <chrono>
+#include <functional>
+#include <future>
 #include <iostream>
+#include <limits>
 #include <map>
+#include <mutex>
 #include <opencv2/opencv.hpp>
-#include <queue>
+#include <optional>
 #include <thread>
 #include <unordered_set>
 #include <sstream>
 
-using Constants::MASKS_COUNT;
+// Input gesture of the benchmark script, positions are in window coordinates.
+struct ScriptedInput {
+	enum Type { POINT, BOX, POSITIVE_POINT, NEGATIVE_POINT, BRUSH, UNSELECT_BRUSH } type;
+	glm::dvec2 startPos;
+	glm::dvec2 endPos; // end of the box or brush stroke
+};
 
 class ImageSegmantationSystem {
 
 	VkDevice device = VK_NULL_HANDLE;
 	VkPhysicalDevice physicalDevice = VK_NULL_HANDLE;
-	std::array<Image, MASKS_COUNT> selectedPosMasks;
+	Image packedSelectedPosMask; // every mask is stored in its own bit of the texel
+	std::vector<uint8_t> packedMaskTexels;
 
 	bool callbackIsSet = false;
 
-	cv::Mat segmentImage(Sam const* sam);
+	cv::Mat segmentImage(Sam const* sam, const SegmentationPrompt& prompt);
+	void decodePrompts();
+	void selectDecodedRegion(const SegmentationPrompt& prompt, const cv::Mat& promptMask);
+	void packMaskPlane(uint16_t maskIndex, glm::uvec2 boundsMin, glm::uvec2 boundsMax);
 
 public:
 	void runObjectSegmentationTask();
 
 	void init(Device& _device, VkCommandPool& _commandPool, GLFWwindow* pWindow,
 		const std::string& imagePath, uint32_t width, uint32_t height,
-		Controls::MouseControl* mouseControl);
+		uint16_t masksCount, Controls::MouseControl* mouseControl);
 	void destroy();
 
 	void changeWindowResolution(glm::uvec2& windowResolution);
 	void removeAllMaskPositions();
 	void removeAllMaskPositions(uint16_t maskIndex);
-	bool selectedObjectSizeChanged();
-	bool selectedObjectSizeChanged(uint16_t maskIndex);
 	void updatePositionMasks(Device& device, VkCommandPool& commandPool, Queue& transferQueue);
-	void inpaintImage(uint8_t patchSize, std::vector<Image>& objectsTextures, Descriptor& descriptor, VkCommandPool& commandPool, Queue& transferQueue);
+	void setBrushParams(float radius, float hardness);
+	Controls::BrushStroke takeBrushStroke();
+	void syncBrushStrokes(Queue& transferQueue);
+	void inpaintImage(uint8_t patchSize, std::vector<Image>& objectsTextures, VkCommandPool& commandPool, Queue& transferQueue);
 	bool& isImageLoaded();
-	const std::shared_ptr<uchar> getSelectedPositionsMask();
-	const std::shared_ptr<uchar> getSelectedPositionsMask(uint16_t maskIndex);
-	const std::array<Image, MASKS_COUNT>& getSelectedPosMasks();
+	float getAutoSegmentationProgress();
+	bool isAutoSegmentationFinished();
+	// False when painting could not be loaded into the model, so selection is not segmented.
+	bool isImageEmbeddingLoaded();
+	/* Selected pixels of the mask are passed to the callback without copying, while the decoder thread is
+	   locked out of the mask. Callback must not call back into segmentation system. */
+	void withSelectedPositionsMask(const std::function<void(const uchar*)>& useMask);
+	void withSelectedPositionsMask(uint16_t maskIndex, const std::function<void(const uchar*)>& useMask);
+	const Image& getSelectedPosMask();
+	SelectionLatency& getSelectionLatency();
+	bool isSelectionSettled();
+	void replayInput(const ScriptedInput& input);
 };
@@ -0,0 +1,98 @@
+#include "selection_latency.h"
+
+const std::array<const char*, SelectionLatency::STAGES_COUNT> stageNames {
+    "Prompt enqueue", "SAM decode", "Mask ingestion", "CPU mask build", "GPU upload",
+    "First frame", "Brush first frame"
+};
+
+void SelectionLatency::enable()
+{
+    enabled = true;
+}
+
+void SelectionLatency::record(Stage stage, Clock::time_point begin, Clock::time_point end)
+{
+    if (!enabled) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    stageSamples[stage].push_back(std::chrono::duration<double, std::milli>(end - begin).count());
+}
+
+void SelectionLatency::selectionIngested(Clock::time_point inputTime)
+{
+    if (!enabled) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    ingestedSelections.push_back(inputTime);
+}
+
+void SelectionLatency::masksUploaded()
+{
+    if (!enabled) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    uploadedSelections.insert(uploadedSelections.end(), ingestedSelections.begin(), ingestedSelections.end());
+    ingestedSelections.clear();
+}
+
+// Brush input that waits for the frame keeps its earliest time.
+void SelectionLatency::brushStamped(Clock::time_point inputTime)
+{
+    if (!enabled) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!stampedBrushInput || inputTime < *stampedBrushInput) {
+        stampedBrushInput = inputTime;
+    }
+}
+
+void SelectionLatency::framePresented()
+{
+    if (!enabled) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    const Clock::time_point presentTime = Clock::now();
+    for (const Clock::time_point inputTime : uploadedSelections) {
+        stageSamples[FIRST_FRAME].push_back(std::chrono::duration<double, std::milli>(presentTime - inputTime).count());
+    }
+    uploadedSelections.clear();
+    if (stampedBrushInput) {
+        stageSamples[BRUSH_FIRST_FRAME].push_back(std::chrono::duration<double, std::milli>(presentTime - *stampedBrushInput).count());
+        stampedBrushInput.reset();
+    }
+}
+
+bool SelectionLatency::hasPendingSelections()
+{
+    if (!enabled) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    return !ingestedSelections.empty() || !uploadedSelections.empty() || stampedBrushInput.has_value();
+}
+
+// Percentile is the nearest sample by rank.
+void SelectionLatency::report(std::ostream& out)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    out << std::format("{:<20}{:>8}{:>10}{:>10}{:>10}{:>10}", "Stage, ms", "count", "p50", "p90", "p99", "max") << '\n';
+    for (size_t stage = 0; stage < STAGES_COUNT; stage++) {
+        std::vector<double> samples = stageSamples[stage];
+        if (samples.empty()) {
+            continue;
+        }
+
+        std::sort(samples.begin(), samples.end());
+        const auto percentile = [&samples](double rank) {
+            return samples[static_cast<size_t>(rank * (samples.size() - 1) + 0.5)];
+        };
+        out << std::format("{:<20}{:>8}{:>10.2f}{:>10.2f}{:>10.2f}{:>10.2f}", stageNames[stage], samples.size(),
+                   percentile(0.5), percentile(0.9), percentile(0.99), samples.back())
+            << '\n';
+    }
+}
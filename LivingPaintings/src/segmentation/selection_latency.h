@@ -0,0 +1,50 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <format>
+#include <mutex>
+#include <optional>
+#include <ostream>
+#include <vector>
+
+/* Durations of the stages that selection passes from input to the first presented frame that shows it.
+   Stages are recorded by input callbacks, segmentation thread and render loop, so samples are kept under mutex.
+   Selection is pending from ingestion until its masks are uploaded and frame is presented after that. Nothing
+   is recorded until recording is enabled by the benchmark, so application does not pay for it. */
+class SelectionLatency {
+
+public:
+    using Clock = std::chrono::steady_clock;
+
+    enum Stage {
+        PROMPT_ENQUEUE, // from input to prompt is taken by decoder thread
+        SAM_DECODE,
+        MASK_INGESTION, // decoded mask is upscaled and stamped into mask regions
+        MASK_BUILD, // dirty rectangles of masks are packed into texels
+        GPU_UPLOAD,
+        FIRST_FRAME, // from input to the first presented frame with uploaded selection
+        BRUSH_FIRST_FRAME, // from brush input to the first presented frame that stamps it
+        STAGES_COUNT
+    };
+
+private:
+    std::atomic<bool> enabled = false;
+    std::mutex mutex;
+    std::array<std::vector<double>, STAGES_COUNT> stageSamples; // in milliseconds
+    std::vector<Clock::time_point> ingestedSelections; // input times of selections that are not uploaded
+    std::vector<Clock::time_point> uploadedSelections; // input times of selections that are not presented
+    std::optional<Clock::time_point> stampedBrushInput;
+
+public:
+    void enable();
+    void record(Stage stage, Clock::time_point begin, Clock::time_point end = Clock::now());
+    void selectionIngested(Clock::time_point inputTime);
+    void masksUploaded();
+    void brushStamped(Clock::time_point inputTime);
+    void framePresented();
+    bool hasPendingSelections();
+    // Prints count, percentiles and maximum of every stage that has samples.
+    void report(std::ostream& out);
+};
@@ -0,0 +1,153 @@
+#include "../segmentation/mask_ingestion.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <opencv2/imgproc.hpp>
+#include <vector>
+
+/* Checks thresholding and label stamping of a decoded mask against scalar loops on a 4K mask store. Part of the
+   store is already selected by another region, so stamping must keep its labels. Time of ingesting the whole
+   decoded mask is printed, and it is checked against the bound only with --check-time. */
+
+const int IMAGE_WIDTH = 3840;
+const int IMAGE_HEIGHT = 2160;
+const uint16_t SELECTED_LABEL = 2;
+const uint16_t STAMPED_LABEL = 3;
+const int TIMED_RUNS = 10;
+const double MAX_INGESTION_TIME_MS = 1.0;
+
+struct MaskStore {
+    std::vector<uint16_t> labels;
+    std::vector<uchar> selectedPixels;
+};
+
+static int failures = 0;
+
+static void check(bool condition, const char* description)
+{
+    if (!condition) {
+        std::cerr << "FAILED: " << description << '\n';
+        failures++;
+    }
+}
+
+// Object with soft border, so threshold is crossed at different values along the border.
+static cv::Mat createDecodedMask()
+{
+    cv::Mat decodedMask = cv::Mat::zeros(IMAGE_HEIGHT, IMAGE_WIDTH, CV_8UC1);
+    cv::ellipse(decodedMask, cv::Point(1900, 1000), cv::Size(400, 250), 30.0, 0.0, 360.0, cv::Scalar(255), cv::FILLED);
+    cv::GaussianBlur(decodedMask, decodedMask, cv::Size(31, 31), 0.0);
+    return decodedMask;
+}
+
+static MaskStore createMaskStore()
+{
+    MaskStore store;
+    store.labels.assign(static_cast<size_t>(IMAGE_WIDTH) * IMAGE_HEIGHT, UNSELECTED_REGION_LABEL);
+    store.selectedPixels.assign(store.labels.size(), 0);
+    for (int y = 900; y < 1100; y++) {
+        for (int x = 1700; x < 2000; x++) {
+            store.labels[static_cast<size_t>(y) * IMAGE_WIDTH + x] = SELECTED_LABEL;
+            store.selectedPixels[static_cast<size_t>(y) * IMAGE_WIDTH + x] = SELECTED_REGION_HIGHLIGHT;
+        }
+    }
+    return store;
+}
+
+static void testThreshold(const cv::Mat& decodedMask, const cv::Mat& binaryMask, const cv::Rect& bounds)
+{
+    cv::Point boundsMin(std::numeric_limits<int>::max(), std::numeric_limits<int>::max());
+    cv::Point boundsMax(-1, -1);
+    bool binaryMatches = binaryMask.size() == decodedMask.size() && binaryMask.type() == CV_8UC1;
+    for (int y = 0; y < decodedMask.rows && binaryMatches; y++) {
+        for (int x = 0; x < decodedMask.cols; x++) {
+            const bool selected = decodedMask.at<uchar>(y, x) > DECODED_MASK_THRESHOLD;
+            binaryMatches = binaryMatches && (binaryMask.at<uchar>(y, x) != 0) == selected;
+            if (selected) {
+                boundsMin = cv::Point(std::min(boundsMin.x, x), std::min(boundsMin.y, y));
+                boundsMax = cv::Point(std::max(boundsMax.x, x), std::max(boundsMax.y, y));
+            }
+        }
+    }
+    check(binaryMatches, "binary mask matches scalar threshold");
+    check(bounds == cv::Rect(boundsMin, boundsMax + cv::Point(1, 1)), "bounds match scalar threshold");
+
+    cv::Mat decodedColorMask;
+    cv::merge(std::vector<cv::Mat> { decodedMask, cv::Mat::zeros(decodedMask.size(), CV_8UC1),
+        cv::Mat(decodedMask.size(), CV_8UC1, cv::Scalar(255)) }, decodedColorMask);
+    cv::Mat colorBinaryMask;
+    const cv::Rect colorBounds = MaskIngestion::thresholdDecodedMask(decodedColorMask, colorBinaryMask);
+    check(colorBounds == bounds && cv::countNonZero(colorBinaryMask != binaryMask) == 0,
+        "first channel of decoded mask is thresholded");
+}
+
+static void testStamp(const cv::Mat& binaryMask, const cv::Rect& bounds)
+{
+    MaskStore expected = createMaskStore();
+    uint32_t expectedPixelCount = 0;
+    for (int y = bounds.y; y < bounds.br().y; y++) {
+        for (int x = bounds.x; x < bounds.br().x; x++) {
+            const size_t pixel = static_cast<size_t>(y) * IMAGE_WIDTH + x;
+            if (binaryMask.at<uchar>(y, x) != 0 && expected.labels[pixel] == UNSELECTED_REGION_LABEL) {
+                expected.labels[pixel] = STAMPED_LABEL;
+                expected.selectedPixels[pixel] = SELECTED_REGION_HIGHLIGHT;
+                expectedPixelCount++;
+            }
+        }
+    }
+
+    MaskStore store = createMaskStore();
+    const uint32_t stampedPixelCount = MaskIngestion::stampLabels(binaryMask(bounds), bounds.tl(), IMAGE_WIDTH,
+        STAMPED_LABEL, store.labels.data(), store.selectedPixels.data());
+    check(expectedPixelCount > 0, "object is not hidden by selected region");
+    check(stampedPixelCount == expectedPixelCount, "stamped pixel count matches scalar stamping");
+    check(store.labels == expected.labels, "labels match scalar stamping");
+    check(store.selectedPixels == expected.selectedPixels, "selected pixels match scalar stamping");
+}
+
+// Full frame is thresholded and its object is stamped, as with decoded mask at image resolution.
+static void testIngestionTime(const cv::Mat& decodedMask, bool checkTime)
+{
+    double bestThresholdTime_ms = std::numeric_limits<double>::max();
+    double bestIngestionTime_ms = std::numeric_limits<double>::max();
+    for (int run = 0; run < TIMED_RUNS; run++) {
+        MaskStore store = createMaskStore();
+        cv::Mat binaryMask;
+        const std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+        const cv::Rect bounds = MaskIngestion::thresholdDecodedMask(decodedMask, binaryMask);
+        const std::chrono::steady_clock::time_point thresholdEnd = std::chrono::steady_clock::now();
+        MaskIngestion::stampLabels(binaryMask(bounds), bounds.tl(), IMAGE_WIDTH, STAMPED_LABEL,
+            store.labels.data(), store.selectedPixels.data());
+        const std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+        bestThresholdTime_ms = std::min(bestThresholdTime_ms, std::chrono::duration<double, std::milli>(thresholdEnd - begin).count());
+        bestIngestionTime_ms = std::min(bestIngestionTime_ms, std::chrono::duration<double, std::milli>(end - begin).count());
+    }
+    std::cout << "Ingestion of " << IMAGE_WIDTH << "x" << IMAGE_HEIGHT << " mask: " << bestIngestionTime_ms << " ms"
+              << " (threshold: " << bestThresholdTime_ms << " ms)" << '\n';
+    if (checkTime) {
+        check(bestIngestionTime_ms < MAX_INGESTION_TIME_MS, "mask is ingested within time bound");
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const bool checkTime = argc > 1 && std::strcmp(argv[1], "--check-time") == 0;
+
+    const cv::Mat decodedMask = createDecodedMask();
+    cv::Mat binaryMask;
+    const cv::Rect bounds = MaskIngestion::thresholdDecodedMask(decodedMask, binaryMask);
+
+    testThreshold(decodedMask, binaryMask, bounds);
+    testStamp(binaryMask, bounds);
+    testIngestionTime(decodedMask, checkTime);
+
+    if (failures > 0) {
+        std::cerr << failures << " checks failed" << '\n';
+        return EXIT_FAILURE;
+    }
+    std::cout << "All checks passed" << '\n';
+    return EXIT_SUCCESS;
+}
@@ -1,26 +0,0 @@
-#include <stdlib.h>
-
-// Aligned memory allocations for different platforms and vendors
-// from Vulkan repository https://github.com/SaschaWillems/Vulkan/blob/master/examples/dynamicuniformbuffer
-
-static void* alignedAlloc(size_t size, size_t alignment)
-{
-    void* data = nullptr;
-#if defined(_MSC_VER) || defined(__MINGW32__)
-    data = _aligned_malloc(size, alignment);
-#else
-    int res = posix_memalign(&data, alignment, size);
-    if (res != 0)
-        data = nullptr;
-#endif
-    return data;
-}
-
-static void alignedFree(void* data)
-{
-#if defined(_MSC_VER) || defined(__MINGW32__)
-    _aligned_free(data);
-#else
-    free(data);
-#endif
-}
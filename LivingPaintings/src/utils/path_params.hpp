@@ -2,7 +2,11 @@
 #include "../config.hpp"
 #include <cstdint>
 #include <string>
+#ifdef _WIN32
 #include <windows.h>
+#else
+#include <filesystem>
+#endif
 
 namespace Runtime {
     static struct PathParams {
@@ -15,10 +19,14 @@ namespace Runtime {
         std::string SAM_MODEL_PATH;
 
         PathParams() {
+#ifdef _WIN32
             DWORD executablePathLength = 140;
             LPSTR lpExecutablePath = (LPSTR)malloc(executablePathLength * sizeof(char));
             GetCurrentDirectoryA(executablePathLength, lpExecutablePath);
             std::string executablePath = std::string(lpExecutablePath);
+#else
+            std::string executablePath = std::filesystem::current_path().string();
+#endif
             TEXTURE_PATH = RETRIEVE_PATH(executablePath, TEXTURE_FILE_PATH);
             SHADER_PATH = RETRIEVE_PATH(executablePath, RESOURCE_SHADER_PATH);
             PREPROCESS_SAM_MODEL_PATH = RETRIEVE_PATH(executablePath, PREPROCESS_SAM_PATH);
@@ -0,0 +1,84 @@
+#include "bindless_registry.h"
+
+using Constants::MAX_BINDLESS_RESOURCES;
+using Constants::BACKGROUND_TEXTURE_SLOT;
+
+void BindlessRegistry::create(VkDevice& device, VkDescriptorSet& bindlessSet, VkSampler& sampler)
+{
+    this->device = device;
+    this->bindlessSet = bindlessSet;
+    this->sampler = sampler;
+
+    // Background slot is never released, lowest free slots are taken first.
+    allocatedSlots.assign(MAX_BINDLESS_RESOURCES, false);
+    allocatedSlots[BACKGROUND_TEXTURE_SLOT] = true;
+    freeSlots.clear();
+    for (uint32_t slot = MAX_BINDLESS_RESOURCES; slot-- > 0;) {
+        if (slot != BACKGROUND_TEXTURE_SLOT) {
+            freeSlots.push_back(slot);
+        }
+    }
+    dirtySlots.clear();
+}
+
+uint32_t BindlessRegistry::allocate(const Image& texture)
+{
+    if (freeSlots.empty()) {
+        throw std::runtime_error("Failed to allocate bindless texture slot, all slots are in use.");
+    }
+
+    const uint32_t slot = freeSlots.back();
+    freeSlots.pop_back();
+    allocatedSlots[slot] = true;
+    update(slot, texture);
+    return slot;
+}
+
+void BindlessRegistry::update(uint32_t slot, const Image& texture)
+{
+    if (slot >= MAX_BINDLESS_RESOURCES || !allocatedSlots[slot]) {
+        throw std::runtime_error("Failed to update bindless texture, slot is not allocated.");
+    }
+
+    VkDescriptorImageInfo textureInfo {};
+    textureInfo.imageLayout = texture.getDetails().layout;
+    textureInfo.imageView = texture.getView();
+    textureInfo.sampler = sampler;
+    dirtySlots.insert_or_assign(slot, textureInfo);
+}
+
+void BindlessRegistry::release(uint32_t slot)
+{
+    if (slot == BACKGROUND_TEXTURE_SLOT || slot >= MAX_BINDLESS_RESOURCES || !allocatedSlots[slot]) {
+        throw std::runtime_error("Failed to release bindless texture slot.");
+    }
+
+    // Released slot stays partially bound, it is not sampled until allocated again.
+    allocatedSlots[slot] = false;
+    freeSlots.push_back(slot);
+    dirtySlots.erase(slot);
+}
+
+// Set layout is created with update after bind, so slots can be written while set is bound.
+void BindlessRegistry::flush()
+{
+    if (dirtySlots.empty()) {
+        return;
+    }
+
+    std::vector<VkWriteDescriptorSet> textureWrites;
+    textureWrites.reserve(dirtySlots.size());
+    for (const auto& [slot, textureInfo] : dirtySlots) {
+        VkWriteDescriptorSet textureWrite = { VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET };
+        textureWrite.dstSet = bindlessSet;
+        textureWrite.dstBinding = 0;
+        textureWrite.dstArrayElement = slot;
+        textureWrite.descriptorCount = 1;
+        textureWrite.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        textureWrite.pImageInfo = &textureInfo;
+        textureWrites.push_back(textureWrite);
+    }
+
+    vkUpdateDescriptorSets(device, static_cast<uint32_t>(textureWrites.size()), textureWrites.data(), 0, nullptr);
+    dirtySlots.clear();
+}
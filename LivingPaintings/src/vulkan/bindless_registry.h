@@ -0,0 +1,28 @@
+#pragma once
+#include "consts.h"
+#include "image.h"
+#include "vulkan/vulkan.h"
+#include <map>
+#include <stdexcept>
+#include <vector>
+
+/* Owns slots of the bindless texture array. Slots are taken from a free list and returned to it when
+   texture is released, so slots are reused after painting is reloaded. Written textures are kept as
+   dirty slots and all of them are written to the descriptor set with single update on flush. */
+class BindlessRegistry {
+
+    VkDevice device = VK_NULL_HANDLE;
+    VkDescriptorSet bindlessSet = VK_NULL_HANDLE;
+    VkSampler sampler = VK_NULL_HANDLE;
+    std::vector<uint32_t> freeSlots;
+    std::vector<bool> allocatedSlots;
+    std::map<uint32_t, VkDescriptorImageInfo> dirtySlots;
+
+public:
+    void create(VkDevice& device, VkDescriptorSet& bindlessSet, VkSampler& sampler);
+    uint32_t allocate(const Image& texture);
+    void update(uint32_t slot, const Image& texture);
+    // Slot must not be sampled by frames that are still in flight.
+    void release(uint32_t slot);
+    void flush();
+};
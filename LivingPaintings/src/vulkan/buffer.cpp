@@ -157,4 +157,111 @@ void UniformBuffer::create(VkDevice& device, VkPhysicalDevice& physicalDevice,
     Buffer::create(device, physicalDevice, size, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
         VK_SHARING_MODE_EXCLUSIVE, memoryProperyFlags);
     vkMapMemory(device, getDeviceMemory(), 0, size, 0, &mapped);
-}
\ No newline at end of file
+}
+
+void InstanceBuffer::create(VkDevice& device, VkPhysicalDevice& physicalDevice, size_t capacity,
+    VkDeviceSize nonCoherentAtomSize)
+{
+    this->physicalDevice = physicalDevice;
+    this->nonCoherentAtomSize = nonCoherentAtomSize;
+    this->capacity = capacity;
+
+    Buffer::create(device, physicalDevice, capacity * sizeof(Data::GraphicsObject::InstanceData),
+        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_SHARING_MODE_EXCLUSIVE,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT);
+    vkMapMemory(device, getDeviceMemory(), 0, VK_WHOLE_SIZE, 0, &mapped);
+}
+
+void InstanceBuffer::markDirty(size_t begin, size_t end)
+{
+    if (begin == end) {
+        return;
+    }
+    if (dirtyBegin == dirtyEnd) {
+        dirtyBegin = begin;
+        dirtyEnd = end;
+    } else {
+        dirtyBegin = std::min(dirtyBegin, begin);
+        dirtyEnd = std::max(dirtyEnd, end);
+    }
+}
+
+bool InstanceBuffer::update(const std::vector<Data::GraphicsObject::InstanceData>& instances)
+{
+    const bool recreated = instances.size() > capacity;
+    if (recreated) {
+        destroy();
+        create(device, physicalDevice, std::max(instances.size(), capacity * 2), nonCoherentAtomSize);
+        markDirty(0, instances.size());
+    }
+
+    dirtyEnd = std::min(dirtyEnd, instances.size());
+    if (dirtyBegin >= dirtyEnd) {
+        dirtyBegin = 0;
+        dirtyEnd = 0;
+        return recreated;
+    }
+
+    const VkDeviceSize instanceSize = sizeof(Data::GraphicsObject::InstanceData);
+    memcpy(static_cast<char*>(mapped) + dirtyBegin * instanceSize, instances.data() + dirtyBegin,
+        (dirtyEnd - dirtyBegin) * instanceSize);
+
+    // Flushed range must be aligned to the non-coherent atom size, range that ends past the buffer is flushed to the end of memory.
+    const VkDeviceSize flushBegin = dirtyBegin * instanceSize / nonCoherentAtomSize * nonCoherentAtomSize;
+    const VkDeviceSize flushEnd = (dirtyEnd * instanceSize + nonCoherentAtomSize - 1) / nonCoherentAtomSize * nonCoherentAtomSize;
+    VkMappedMemoryRange mappedMemoryRange {};
+    mappedMemoryRange.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
+    mappedMemoryRange.memory = getDeviceMemory();
+    mappedMemoryRange.offset = flushBegin;
+    mappedMemoryRange.size = flushEnd <= memorySize ? flushEnd - flushBegin : VK_WHOLE_SIZE;
+    vkFlushMappedMemoryRanges(device, 1, &mappedMemoryRange);
+
+    dirtyBegin = 0;
+    dirtyEnd = 0;
+    return recreated;
+}
+
+void UniformRingBuffer::create(VkDevice& device, VkPhysicalDevice& physicalDevice,
+    const std::vector<VkDeviceSize>& uniformSizes, const VkPhysicalDeviceLimits& limits)
+{
+    // Regions are flushed separately, so frame stride is also aligned to the non-coherent atom size.
+    const VkDeviceSize uniformAlignment = limits.minUniformBufferOffsetAlignment;
+    const VkDeviceSize frameAlignment = std::max(uniformAlignment, limits.nonCoherentAtomSize);
+    auto alignUp = [](VkDeviceSize size, VkDeviceSize alignment) {
+        return (size + alignment - 1) / alignment * alignment;
+    };
+
+    this->uniformSizes = uniformSizes;
+    uniformOffsets.clear();
+    VkDeviceSize regionSize = 0;
+    for (const VkDeviceSize uniformSize : uniformSizes) {
+        uniformOffsets.push_back(regionSize);
+        regionSize = alignUp(regionSize + uniformSize, uniformAlignment);
+    }
+    frameStride = alignUp(regionSize, frameAlignment);
+
+    Buffer::create(device, physicalDevice, frameStride * Constants::MAX_FRAMES_IN_FLIGHT,
+        VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VK_SHARING_MODE_EXCLUSIVE,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT);
+    vkMapMemory(device, getDeviceMemory(), 0, VK_WHOLE_SIZE, 0, &mapped);
+}
+
+void UniformRingBuffer::flush(uint32_t frame)
+{
+    VkMappedMemoryRange mappedMemoryRange {};
+    mappedMemoryRange.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
+    mappedMemoryRange.memory = getDeviceMemory();
+    mappedMemoryRange.offset = frame * frameStride;
+    mappedMemoryRange.size = frameStride;
+    vkFlushMappedMemoryRanges(device, 1, &mappedMemoryRange);
+}
+
+VkDeviceSize UniformRingBuffer::getOffset(uint32_t frame, uint32_t uniformIndex) const
+{
+    return frame * frameStride + uniformOffsets[uniformIndex];
+}
+
+VkDeviceSize UniformRingBuffer::getRange(uint32_t uniformIndex) const
+{
+    return uniformSizes[uniformIndex];
+}
@@ -78,7 +78,47 @@ public:
     inline void update(const T& uniform) {
         memcpy(mapped, &uniform, sizeof(uniform));
     };
-    inline void update(const Data::GraphicsObject::Instance& uniform) {
-        memcpy(mapped, uniform.model, memorySize);
+};
+
+/* Tightly packed instance data of one frame in flight. Buffer is recreated with doubled capacity when
+   instances do not fit, otherwise only instances written since the last update of this frame are
+   copied and flushed. */
+class InstanceBuffer : public Buffer {
+
+    void* mapped = nullptr;
+    VkPhysicalDevice physicalDevice = VK_NULL_HANDLE;
+    VkDeviceSize nonCoherentAtomSize = 1;
+    size_t capacity = 0;
+    size_t dirtyBegin = 0;
+    size_t dirtyEnd = 0;
+
+public:
+    void create(VkDevice& device, VkPhysicalDevice& physicalDevice, size_t capacity,
+        VkDeviceSize nonCoherentAtomSize);
+    void markDirty(size_t begin, size_t end);
+    // Returns true when buffer was recreated, so descriptor of the frame must be updated.
+    bool update(const std::vector<Data::GraphicsObject::InstanceData>& instances);
+};
+
+/* Frame-global uniforms of every frame in flight, stored in regions of a single persistently mapped buffer.
+   Frame writes only its own region, so uniforms of the recorded frame do not overwrite uniforms that
+   frames in flight still read, and whole region is flushed at once. */
+class UniformRingBuffer : public Buffer {
+
+    void* mapped = nullptr;
+    VkDeviceSize frameStride = 0;
+    std::vector<VkDeviceSize> uniformOffsets; // offsets within frame region
+    std::vector<VkDeviceSize> uniformSizes;
+
+public:
+    void create(VkDevice& device, VkPhysicalDevice& physicalDevice,
+        const std::vector<VkDeviceSize>& uniformSizes, const VkPhysicalDeviceLimits& limits);
+    void flush(uint32_t frame);
+    VkDeviceSize getOffset(uint32_t frame, uint32_t uniformIndex) const;
+    VkDeviceSize getRange(uint32_t uniformIndex) const;
+
+    template<typename T>
+    inline void update(uint32_t frame, uint32_t uniformIndex, const T& uniform) {
+        memcpy(static_cast<char*>(mapped) + getOffset(frame, uniformIndex), &uniform, sizeof(uniform));
     };
 };
@@ -33,23 +33,85 @@ static const VkSampleCountFlagBits MAX_SAMPLE_COUNT = VkSampleCountFlagBits::VK_
 
 static const VkFormat IMAGE_TEXTURE_FORMAT = VK_FORMAT_R8G8B8A8_SRGB;
 static const VkFormat BUMP_TEXTURE_FORMAT = VK_FORMAT_R8_UNORM;
-static const VkFormat EFFECT_MASK_TEXTURE_FORMAT = VK_FORMAT_R8_UNORM;
+static const VkFormat NOISE_TEXTURE_FORMAT = VK_FORMAT_R16_SFLOAT;
+
+// Noise texture is baked once per noise scale change and sampled with repeat addressing.
+static const uint32_t NOISE_TEXTURE_SIZE = 1024;
+static const uint32_t NOISE_WORKGROUP_SIZE = 16;
+
+// Graphics pipelines are built from shader files that share the name, e.g. painting.vert and painting.frag.
+inline static const std::string PAINTING_SHADER_NAME = "painting";
+inline static const std::string UPSCALE_SHADER_NAME = "upscale";
+inline static const std::string HEIGHT_MAP_COMPUTE_SHADER = "computeHeight.comp";
+inline static const std::string NOISE_COMPUTE_SHADER = "computeNoise.comp";
+inline static const std::string BRUSH_COMPUTE_SHADER = "brushMask.comp";
+
+// Brush samples are stamped into the mask by compute shader, sample count must match brushMask.comp.
+static const size_t MAX_BRUSH_SAMPLES = 64;
+static const uint32_t BRUSH_WORKGROUP_SIZE = 16;
+static const float DEFAULT_BRUSH_RADIUS = 1.5f; // in image pixels
+static const float MAX_BRUSH_RADIUS = 64.0f;
+static const float DEFAULT_BRUSH_HARDNESS = 0.5f; // part of radius that is fully selected
+
+// Painting is rendered at a fraction of the swapchain extent and upscaled before the UI is drawn.
+static const float MIN_RENDER_SCALE = 0.25f;
+static const float MAX_RENDER_SCALE = 1.0f;
+
+// Pipelines built on shader reloads are kept for comparison, the oldest are destroyed when history is full.
+static const size_t MAX_PIPELINE_HISTORY_SIZE = 8;
+
+// Quality governor averages GPU time of sampled frames and keeps it within the frame budget.
+static const float DEFAULT_FRAME_BUDGET_MS = 16.6f;
+static const uint32_t QUALITY_SAMPLE_FRAMES = 30;
+static const float QUALITY_RAISE_THRESHOLD = 0.7f; // fraction of the budget below which quality is raised
+// Sampled windows in a row that must ask for the same change before sample count is changed.
+static const uint32_t SAMPLE_COUNT_CHANGE_WINDOWS = 5;
+static const float MIN_PARALLAX_LAYERS = 4.0f;
+static const float MAX_PARALLAX_LAYERS = 64.0f;
 
 static const VkColorSpaceKHR COLOR_SPACE = VK_COLOR_SPACE_HDR10_HLG_EXT;
 
 // from 0 - 255
 static const uint8_t SELECTED_REGION_HIGHLIGHT = 70;
+// Pixel of the decoded mask is selected when its value is greater than threshold.
+static const uint8_t DECODED_MASK_THRESHOLD = 127;
+// Labels of mask regions, regions selected by segmentation take labels after brush label.
+static const uint16_t UNSELECTED_REGION_LABEL = 0;
+static const uint16_t BRUSH_REGION_LABEL = 1;
+// Drag shorter than this in window pixels selects with point instead of box.
+static const double SELECTION_BOX_MIN_SIZE = 8.0;
+// Automatic segmentation prompts the model with grid of points, every point is one decoder run.
+static const int AUTO_SEGMENTATION_GRID_SIZE = 16;
 
+// Initial capacity of instance buffers, they grow when more objects are constructed.
 static const size_t OBJECT_INSTANCES = 100;
 static const uint32_t MAX_BINDLESS_RESOURCES = 100;
+// Bindless slot of the painting background, it is sampled by painting quad and height map compute shader.
+static const uint32_t BACKGROUND_TEXTURE_SLOT = 0;
 
-static const uint16_t EFFECTS_COUNT = 3;
-static constexpr uint16_t MASKS_COUNT = EFFECTS_COUNT + 1;
+/* Effects that painting shader implements, shader finds mask of the effect by its id. Effect set is listed at
+   runtime; every effect of the set has its own mask and mask 0 is used for object selection. */
+enum EffectId : uint32_t { SWAY_EFFECT, FLICKERING_LIGHT_EFFECT, HIGHLIGHT_EFFECT, EFFECT_IDS_COUNT };
+struct Effect {
+	EffectId id;
+	std::string name;
+};
+inline static const std::vector<Effect> DEFAULT_EFFECTS = {
+	{ SWAY_EFFECT, "Sway" }, { FLICKERING_LIGHT_EFFECT, "Flickering Light" }, { HIGHLIGHT_EFFECT, "Highlight" }
+};
+// Effect masks are passed to shaders as single uvec4.
+static const uint32_t MAX_EFFECT_IDS = 4;
+// Masks are packed as bit planes into single unsigned integer texel, so count is limited by its bit width.
+static const uint16_t MAX_MASKS_COUNT = 32;
 
 static const uint8_t DEFAULT_PATCH_SIZE = 20;
 static const std::string INPAINTING_HISTORY_FOLDER_NAME = "InpaintingHistory";
 
 static const std::string OUTPUT_FOLDER_NAME = "Output";
+// Pipeline cache is saved on shutdown and reused only by the same device and driver version.
+static const std::string PIPELINE_CACHE_FILE_NAME = "pipeline_cache.bin";
+// Compiled SPIR-V is stored in the output folder under the hash of its sources and compile options.
+static const std::string SHADER_CACHE_FOLDER_NAME = "ShaderCache";
 
 static const uint32_t STREAM_FRAME_RATE = 25;
 static const uint32_t EXPORT_FRAME_COUNT = 200;
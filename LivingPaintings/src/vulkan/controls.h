@@ -1,4 +1,5 @@
 #pragma once
+#include "consts.h"
 #include "glm/glm.hpp"
 #include <GLFW/glfw3.h>
 
@@ -13,6 +14,17 @@ public:
         int maskIndex;
     };
 
+    // Brush samples of one frame, layout matches uniform of brushMask.comp.
+    struct BrushStroke {
+        glm::ivec2 boundsMin; // first pixel of the dispatch
+        glm::uvec2 boundsSize;
+        uint32_t sampleCount;
+        uint32_t maskBit;
+        float hardness;
+        float padding;
+        glm::vec4 samples[Constants::MAX_BRUSH_SAMPLES]; // xy is position, z is radius, w is 1 when sample unselects
+    };
+
     void fillInMouseControlInfo(glm::uvec2 windowSize, float squareSize,
         GLFWwindow* pWindow);
     void updateMousePos(const glm::dvec2& mousePos);
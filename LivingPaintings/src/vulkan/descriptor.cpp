@@ -4,14 +4,15 @@ using Constants::MAX_FRAMES_IN_FLIGHT;
 using Constants::MAX_BINDLESS_RESOURCES;
 
 void Descriptor::create(VkDevice& device,
-	std::vector<UniformBuffer> uniformInstanceBuffers,
+	std::vector<InstanceBuffer>& instanceBuffers,
 	std::vector<UniformBuffer> uniformViewBuffers,
 	Image& paintingTexture, Image& heightMapTexture, Sampler& textureSampler,
-	UniformBuffer& mouseUniform, const std::array<Image, MASKS_COUNT>& selectedPosMasks,
-	UniformBuffer& timeUniform, UniformBuffer& effectParamsUniform, UniformBuffer& lightParamsUniform)
+	UniformRingBuffer& frameUniforms, const Image& selectedPosMask, Sampler& maskSampler,
+	Image& noiseTexture, Image& sceneTexture)
 {
 	this->device = device;
 	this->sampler = textureSampler.get();
+	this->maskSampler = maskSampler.get();
 
 	VkDescriptorBindingFlags bindlessFlags = VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT_EXT
 		| VK_DESCRIPTOR_BINDING_VARIABLE_DESCRIPTOR_COUNT_BIT_EXT
@@ -23,7 +24,7 @@ void Descriptor::create(VkDevice& device,
 	VkDescriptorSetLayoutBinding instanceLayoutBinding{};
 	instanceLayoutBinding.binding = 0;
 	instanceLayoutBinding.descriptorCount = 1;
-	instanceLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+	instanceLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
 	instanceLayoutBinding.pImmutableSamplers = nullptr;
 	instanceLayoutBinding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
 	bindings.push_back(instanceLayoutBinding);
@@ -62,7 +63,7 @@ void Descriptor::create(VkDevice& device,
 
 	VkDescriptorSetLayoutBinding selectedPosMaskLayoutBinding{};
 	selectedPosMaskLayoutBinding.binding = 5;
-	selectedPosMaskLayoutBinding.descriptorCount = MASKS_COUNT;
+	selectedPosMaskLayoutBinding.descriptorCount = 1;
 	selectedPosMaskLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
 	selectedPosMaskLayoutBinding.pImmutableSamplers = nullptr;
 	selectedPosMaskLayoutBinding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
@@ -81,7 +82,7 @@ void Descriptor::create(VkDevice& device,
 	effectsParamsLayoutBinding.descriptorCount = 1;
 	effectsParamsLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
 	effectsParamsLayoutBinding.pImmutableSamplers = nullptr;
-	effectsParamsLayoutBinding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+	effectsParamsLayoutBinding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT | VK_SHADER_STAGE_COMPUTE_BIT;
 	bindings.push_back(effectsParamsLayoutBinding);
 
 	VkDescriptorSetLayoutBinding lightParamsLayoutBinding{};
@@ -92,6 +93,47 @@ void Descriptor::create(VkDevice& device,
 	lightParamsLayoutBinding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
 	bindings.push_back(lightParamsLayoutBinding);
 
+	VkDescriptorSetLayoutBinding noiseTextureBinding{};
+	noiseTextureBinding.binding = 9;
+	noiseTextureBinding.descriptorCount = 1;
+	noiseTextureBinding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+	noiseTextureBinding.pImmutableSamplers = nullptr;
+	noiseTextureBinding.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+	bindings.push_back(noiseTextureBinding);
+
+	VkDescriptorSetLayoutBinding noiseTextureSamplerBinding{};
+	noiseTextureSamplerBinding.binding = 10;
+	noiseTextureSamplerBinding.descriptorCount = 1;
+	noiseTextureSamplerBinding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	noiseTextureSamplerBinding.pImmutableSamplers = nullptr;
+	noiseTextureSamplerBinding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+	bindings.push_back(noiseTextureSamplerBinding);
+
+	VkDescriptorSetLayoutBinding sceneTextureSamplerBinding{};
+	sceneTextureSamplerBinding.binding = 11;
+	sceneTextureSamplerBinding.descriptorCount = 1;
+	sceneTextureSamplerBinding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	sceneTextureSamplerBinding.pImmutableSamplers = nullptr;
+	sceneTextureSamplerBinding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+	bindings.push_back(sceneTextureSamplerBinding);
+
+	VkDescriptorSetLayoutBinding brushStrokeLayoutBinding{};
+	brushStrokeLayoutBinding.binding = 12;
+	brushStrokeLayoutBinding.descriptorCount = 1;
+	brushStrokeLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+	brushStrokeLayoutBinding.pImmutableSamplers = nullptr;
+	brushStrokeLayoutBinding.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+	bindings.push_back(brushStrokeLayoutBinding);
+
+	// Mask is stamped by brush as storage image and sampled by painting from binding 5.
+	VkDescriptorSetLayoutBinding selectedPosMaskStorageBinding{};
+	selectedPosMaskStorageBinding.binding = 13;
+	selectedPosMaskStorageBinding.descriptorCount = 1;
+	selectedPosMaskStorageBinding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+	selectedPosMaskStorageBinding.pImmutableSamplers = nullptr;
+	selectedPosMaskStorageBinding.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+	bindings.push_back(selectedPosMaskStorageBinding);
+
 	VkDescriptorSetLayoutCreateInfo descriptorSetLayoutInfo{};
 	descriptorSetLayoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
 	descriptorSetLayoutInfo.bindingCount = static_cast<uint32_t>(bindings.size());
@@ -125,7 +167,7 @@ void Descriptor::create(VkDevice& device,
 	}
 
 	std::vector<VkDescriptorPoolSize> poolSizes(bindings.size());
-	poolSizes[0].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+	poolSizes[0].type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
 	poolSizes[0].descriptorCount = static_cast<uint32_t>(Constants::MAX_FRAMES_IN_FLIGHT) * 2;
 	poolSizes[1].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
 	poolSizes[1].descriptorCount = static_cast<uint32_t>(Constants::MAX_FRAMES_IN_FLIGHT) * 2;
@@ -136,19 +178,29 @@ void Descriptor::create(VkDevice& device,
 	poolSizes[4].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
 	poolSizes[4].descriptorCount = 1;
 	poolSizes[5].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-	poolSizes[5].descriptorCount = static_cast<uint32_t>(Constants::MAX_FRAMES_IN_FLIGHT) * MASKS_COUNT;
+	poolSizes[5].descriptorCount = static_cast<uint32_t>(Constants::MAX_FRAMES_IN_FLIGHT);
 	poolSizes[6].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
 	poolSizes[6].descriptorCount = 1;
 	poolSizes[7].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
 	poolSizes[7].descriptorCount = 1;
 	poolSizes[8].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
 	poolSizes[8].descriptorCount = 1;
+	poolSizes[9].type = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+	poolSizes[9].descriptorCount = static_cast<uint32_t>(Constants::MAX_FRAMES_IN_FLIGHT);
+	poolSizes[10].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	poolSizes[10].descriptorCount = static_cast<uint32_t>(Constants::MAX_FRAMES_IN_FLIGHT);
+	poolSizes[11].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	poolSizes[11].descriptorCount = static_cast<uint32_t>(Constants::MAX_FRAMES_IN_FLIGHT);
+	poolSizes[12].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+	poolSizes[12].descriptorCount = static_cast<uint32_t>(Constants::MAX_FRAMES_IN_FLIGHT);
+	poolSizes[13].type = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+	poolSizes[13].descriptorCount = static_cast<uint32_t>(Constants::MAX_FRAMES_IN_FLIGHT);
 
 	VkDescriptorPoolCreateInfo poolInfo{};
 	poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
 	poolInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
 	poolInfo.pPoolSizes = poolSizes.data();
-	poolInfo.maxSets = bindings.size() + MASKS_COUNT;
+	poolInfo.maxSets = bindings.size() + MAX_FRAMES_IN_FLIGHT + 1; // per frame sets and ImGui font set
 
 	std::vector<VkDescriptorPoolSize> bindlessPoolSizes(bindlessTexturesBindings.size());
 	bindlessPoolSizes[0].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
@@ -198,9 +250,9 @@ void Descriptor::create(VkDevice& device,
 
 	for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
 		VkDescriptorBufferInfo instanceBufferInfo{};
-		instanceBufferInfo.buffer = uniformInstanceBuffers[i].get();
+		instanceBufferInfo.buffer = instanceBuffers[i].get();
 		instanceBufferInfo.offset = 0;
-		instanceBufferInfo.range = Data::AlignmentProperties::dynamicUniformAlignment_mat4;
+		instanceBufferInfo.range = VK_WHOLE_SIZE;
 
 		VkDescriptorBufferInfo viewBufferInfo{};
 		viewBufferInfo.buffer = uniformViewBuffers[i].get();
@@ -217,38 +269,59 @@ void Descriptor::create(VkDevice& device,
 		bumpTextureSamplerInfo.sampler = textureSampler.get();
 
 		VkDescriptorBufferInfo mousePosBufferInfo{};
-		mousePosBufferInfo.buffer = mouseUniform.get();
-		mousePosBufferInfo.offset = 0;
-		mousePosBufferInfo.range = sizeof(Controls::MouseControl);
-
-		std::array<VkDescriptorImageInfo, MASKS_COUNT> selectedPosMaskInfo{};
-		for (uint16_t maskIndex = 0; maskIndex < MASKS_COUNT; maskIndex++) {
-			selectedPosMaskInfo[maskIndex].imageLayout = selectedPosMasks[maskIndex].getDetails().layout;
-			selectedPosMaskInfo[maskIndex].imageView = selectedPosMasks[maskIndex].getView();
-			selectedPosMaskInfo[maskIndex].sampler = textureSampler.get();
-		}
+		mousePosBufferInfo.buffer = frameUniforms.get();
+		mousePosBufferInfo.offset = frameUniforms.getOffset(i, Data::MOUSE_CONTROL_UNIFORM);
+		mousePosBufferInfo.range = frameUniforms.getRange(Data::MOUSE_CONTROL_UNIFORM);
+
+		VkDescriptorImageInfo selectedPosMaskInfo{};
+		selectedPosMaskInfo.imageLayout = selectedPosMask.getDetails().layout;
+		selectedPosMaskInfo.imageView = selectedPosMask.getView();
+		selectedPosMaskInfo.sampler = maskSampler.get();
 
 		VkDescriptorBufferInfo timeBufferInfo{};
-		timeBufferInfo.buffer = timeUniform.get();
-		timeBufferInfo.offset = 0;
-		timeBufferInfo.range = sizeof(float);
+		timeBufferInfo.buffer = frameUniforms.get();
+		timeBufferInfo.offset = frameUniforms.getOffset(i, Data::TIME_UNIFORM);
+		timeBufferInfo.range = frameUniforms.getRange(Data::TIME_UNIFORM);
 
 		VkDescriptorBufferInfo effectsParamsBufferInfo{};
-		effectsParamsBufferInfo.buffer = effectParamsUniform.get();
-		effectsParamsBufferInfo.offset = 0;
-		effectsParamsBufferInfo.range = sizeof(EffectParams);
+		effectsParamsBufferInfo.buffer = frameUniforms.get();
+		effectsParamsBufferInfo.offset = frameUniforms.getOffset(i, Data::EFFECT_PARAMS_UNIFORM);
+		effectsParamsBufferInfo.range = frameUniforms.getRange(Data::EFFECT_PARAMS_UNIFORM);
 
 		VkDescriptorBufferInfo lightParamsBufferInfo{};
-		lightParamsBufferInfo.buffer = lightParamsUniform.get();
-		lightParamsBufferInfo.offset = 0;
-		lightParamsBufferInfo.range = sizeof(LightParams);
+		lightParamsBufferInfo.buffer = frameUniforms.get();
+		lightParamsBufferInfo.offset = frameUniforms.getOffset(i, Data::LIGHT_PARAMS_UNIFORM);
+		lightParamsBufferInfo.range = frameUniforms.getRange(Data::LIGHT_PARAMS_UNIFORM);
+
+		VkDescriptorImageInfo noiseTextureInfo{};
+		noiseTextureInfo.imageLayout = noiseTexture.getDetails().layout;
+		noiseTextureInfo.imageView = noiseTexture.getView();
+
+		VkDescriptorImageInfo noiseTextureSamplerInfo{};
+		noiseTextureSamplerInfo.imageLayout = noiseTexture.getDetails().layout;
+		noiseTextureSamplerInfo.imageView = noiseTexture.getView();
+		noiseTextureSamplerInfo.sampler = textureSampler.get();
+
+		VkDescriptorImageInfo sceneTextureSamplerInfo{};
+		sceneTextureSamplerInfo.imageLayout = sceneTexture.getDetails().layout;
+		sceneTextureSamplerInfo.imageView = sceneTexture.getView();
+		sceneTextureSamplerInfo.sampler = textureSampler.get();
+
+		VkDescriptorBufferInfo brushStrokeBufferInfo{};
+		brushStrokeBufferInfo.buffer = frameUniforms.get();
+		brushStrokeBufferInfo.offset = frameUniforms.getOffset(i, Data::BRUSH_STROKE_UNIFORM);
+		brushStrokeBufferInfo.range = frameUniforms.getRange(Data::BRUSH_STROKE_UNIFORM);
+
+		VkDescriptorImageInfo selectedPosMaskStorageInfo{};
+		selectedPosMaskStorageInfo.imageLayout = selectedPosMask.getDetails().layout;
+		selectedPosMaskStorageInfo.imageView = selectedPosMask.getView();
 
 		std::vector<VkWriteDescriptorSet> writeDescriptorSets(bindings.size());
 		writeDescriptorSets[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
 		writeDescriptorSets[0].dstSet = sets[i];
 		writeDescriptorSets[0].dstBinding = 0;
 		writeDescriptorSets[0].dstArrayElement = 0;
-		writeDescriptorSets[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+		writeDescriptorSets[0].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
 		writeDescriptorSets[0].descriptorCount = 1;
 		writeDescriptorSets[0].pBufferInfo = &instanceBufferInfo;
 
@@ -289,8 +362,8 @@ void Descriptor::create(VkDevice& device,
 		writeDescriptorSets[5].dstBinding = 5;
 		writeDescriptorSets[5].dstArrayElement = 0;
 		writeDescriptorSets[5].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-		writeDescriptorSets[5].descriptorCount = MASKS_COUNT;
-		writeDescriptorSets[5].pImageInfo = selectedPosMaskInfo.data();
+		writeDescriptorSets[5].descriptorCount = 1;
+		writeDescriptorSets[5].pImageInfo = &selectedPosMaskInfo;
 
 		writeDescriptorSets[6].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
 		writeDescriptorSets[6].dstSet = sets[i];
@@ -324,47 +397,68 @@ void Descriptor::create(VkDevice& device,
 		writeDescriptorSets[8].descriptorCount = 1;
 		writeDescriptorSets[8].pBufferInfo = &lightParamsBufferInfo;
 
+		writeDescriptorSets[9].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		writeDescriptorSets[9].dstSet = sets[i];
+		writeDescriptorSets[9].dstBinding = 9;
+		writeDescriptorSets[9].dstArrayElement = 0;
+		writeDescriptorSets[9].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+		writeDescriptorSets[9].descriptorCount = 1;
+		writeDescriptorSets[9].pImageInfo = &noiseTextureInfo;
+
+		writeDescriptorSets[10].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		writeDescriptorSets[10].dstSet = sets[i];
+		writeDescriptorSets[10].dstBinding = 10;
+		writeDescriptorSets[10].dstArrayElement = 0;
+		writeDescriptorSets[10].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		writeDescriptorSets[10].descriptorCount = 1;
+		writeDescriptorSets[10].pImageInfo = &noiseTextureSamplerInfo;
+
+		writeDescriptorSets[11].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		writeDescriptorSets[11].dstSet = sets[i];
+		writeDescriptorSets[11].dstBinding = 11;
+		writeDescriptorSets[11].dstArrayElement = 0;
+		writeDescriptorSets[11].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		writeDescriptorSets[11].descriptorCount = 1;
+		writeDescriptorSets[11].pImageInfo = &sceneTextureSamplerInfo;
+
+		writeDescriptorSets[12].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		writeDescriptorSets[12].dstSet = sets[i];
+		writeDescriptorSets[12].dstBinding = 12;
+		writeDescriptorSets[12].dstArrayElement = 0;
+		writeDescriptorSets[12].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+		writeDescriptorSets[12].descriptorCount = 1;
+		writeDescriptorSets[12].pBufferInfo = &brushStrokeBufferInfo;
+
+		writeDescriptorSets[13].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		writeDescriptorSets[13].dstSet = sets[i];
+		writeDescriptorSets[13].dstBinding = 13;
+		writeDescriptorSets[13].dstArrayElement = 0;
+		writeDescriptorSets[13].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+		writeDescriptorSets[13].descriptorCount = 1;
+		writeDescriptorSets[13].pImageInfo = &selectedPosMaskStorageInfo;
+
 		vkUpdateDescriptorSets(device, static_cast<uint32_t>(writeDescriptorSets.size()),
 			writeDescriptorSets.data(), 0, nullptr);
 	}
-
-	VkDescriptorImageInfo paintingTextureInfo{};
-	paintingTextureInfo.imageLayout = paintingTexture.getDetails().layout;
-	paintingTextureInfo.imageView = paintingTexture.getView();
-	paintingTextureInfo.sampler = textureSampler.get();
-
-	VkWriteDescriptorSet bindlessTextureDescriptorSetWrite = { VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET };
-	bindlessTextureDescriptorSetWrite.dstSet = bindlessSets[0];
-	bindlessTextureDescriptorSetWrite.dstBinding = 0;
-	bindlessTextureDescriptorSetWrite.dstArrayElement = 0;
-	bindlessTextureDescriptorSetWrite.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-	bindlessTextureDescriptorSetWrite.descriptorCount = 1;
-	bindlessTextureDescriptorSetWrite.pImageInfo = &paintingTextureInfo;
-
-	vkUpdateDescriptorSets(device, 1,
-		&bindlessTextureDescriptorSetWrite, 0, nullptr);
 }
 
-//TODO update resources for many textures and use dstBinding as texture id
-void Descriptor::updateBindlessTexture(Image& textureWrite, uint32_t arrayElementId)
+// Instance buffer is recreated when it grows, only set of the frame that is not in flight is updated.
+void Descriptor::updateInstanceBuffer(InstanceBuffer& instanceBuffer, uint32_t frame)
 {
-		uint32_t bindingId = textureWrite.imageDetails.bindingId;
-		VkDescriptorImageInfo textureWriteInfo{};
-		textureWriteInfo.imageLayout = textureWrite.getDetails().layout;
-		textureWriteInfo.imageView = textureWrite.getView();
-		if (sampler != VK_NULL_HANDLE) {
-			textureWriteInfo.sampler = sampler;
-		}
-
-		VkWriteDescriptorSet textureDescriptorSetWrite = { VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET };
-		textureDescriptorSetWrite.dstSet = bindlessSets[0];
-		textureDescriptorSetWrite.dstBinding = bindingId;
-		textureDescriptorSetWrite.dstArrayElement = arrayElementId;
-		textureDescriptorSetWrite.descriptorCount = 1;
-		textureDescriptorSetWrite.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-		textureDescriptorSetWrite.pImageInfo = &textureWriteInfo;
-		vkUpdateDescriptorSets(device, 1, &textureDescriptorSetWrite,
-			0, nullptr);
+	VkDescriptorBufferInfo instanceBufferInfo{};
+	instanceBufferInfo.buffer = instanceBuffer.get();
+	instanceBufferInfo.offset = 0;
+	instanceBufferInfo.range = VK_WHOLE_SIZE;
+
+	VkWriteDescriptorSet instanceBufferDescriptorSetWrite = { VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET };
+	instanceBufferDescriptorSetWrite.dstSet = sets[frame];
+	instanceBufferDescriptorSetWrite.dstBinding = 0;
+	instanceBufferDescriptorSetWrite.dstArrayElement = 0;
+	instanceBufferDescriptorSetWrite.descriptorCount = 1;
+	instanceBufferDescriptorSetWrite.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	instanceBufferDescriptorSetWrite.pBufferInfo = &instanceBufferInfo;
+	vkUpdateDescriptorSets(device, 1, &instanceBufferDescriptorSetWrite,
+		0, nullptr);
 }
 
 void Descriptor::updateHeightTexture(Image& heightTexture)
@@ -405,31 +499,65 @@ void Descriptor::updateHeightTexture(Image& heightTexture)
 	}
 }
 
-void Descriptor::updateMaskTextures(const std::array<Image, MASKS_COUNT>& maskTextures)
+void Descriptor::updateMaskTexture(const Image& maskTexture)
 {
 	for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
-		std::array<VkDescriptorImageInfo, MASKS_COUNT> selectedPosMaskInfo{};
-		for (uint16_t maskIndex = 0; maskIndex < MASKS_COUNT; maskIndex++) {
-			selectedPosMaskInfo[maskIndex].imageLayout = maskTextures[maskIndex].getDetails().layout;
-			selectedPosMaskInfo[maskIndex].imageView = maskTextures[maskIndex].getView();
-
-			if (sampler != VK_NULL_HANDLE) {
-				selectedPosMaskInfo[maskIndex].sampler = sampler;
-			}
+		VkDescriptorImageInfo selectedPosMaskInfo{};
+		selectedPosMaskInfo.imageLayout = maskTexture.getDetails().layout;
+		selectedPosMaskInfo.imageView = maskTexture.getView();
+
+		if (maskSampler != VK_NULL_HANDLE) {
+			selectedPosMaskInfo.sampler = maskSampler;
 		}
 
-		VkWriteDescriptorSet maskTexturesDescriptorSetWrite = { VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET };
-		maskTexturesDescriptorSetWrite.dstSet = sets[i];
-		maskTexturesDescriptorSetWrite.dstBinding = 5;
-		maskTexturesDescriptorSetWrite.dstArrayElement = 0;
-		maskTexturesDescriptorSetWrite.descriptorCount = MASKS_COUNT;
-		maskTexturesDescriptorSetWrite.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-		maskTexturesDescriptorSetWrite.pImageInfo = selectedPosMaskInfo.data();
-		vkUpdateDescriptorSets(device, 1, &maskTexturesDescriptorSetWrite,
+		VkWriteDescriptorSet maskTextureDescriptorSetWrite = { VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET };
+		maskTextureDescriptorSetWrite.dstSet = sets[i];
+		maskTextureDescriptorSetWrite.dstBinding = 5;
+		maskTextureDescriptorSetWrite.dstArrayElement = 0;
+		maskTextureDescriptorSetWrite.descriptorCount = 1;
+		maskTextureDescriptorSetWrite.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		maskTextureDescriptorSetWrite.pImageInfo = &selectedPosMaskInfo;
+		vkUpdateDescriptorSets(device, 1, &maskTextureDescriptorSetWrite,
+			0, nullptr);
+
+		VkDescriptorImageInfo selectedPosMaskStorageInfo{};
+		selectedPosMaskStorageInfo.imageLayout = maskTexture.getDetails().layout;
+		selectedPosMaskStorageInfo.imageView = maskTexture.getView();
+
+		VkWriteDescriptorSet maskStorageDescriptorSetWrite = { VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET };
+		maskStorageDescriptorSetWrite.dstSet = sets[i];
+		maskStorageDescriptorSetWrite.dstBinding = 13;
+		maskStorageDescriptorSetWrite.dstArrayElement = 0;
+		maskStorageDescriptorSetWrite.descriptorCount = 1;
+		maskStorageDescriptorSetWrite.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+		maskStorageDescriptorSetWrite.pImageInfo = &selectedPosMaskStorageInfo;
+		vkUpdateDescriptorSets(device, 1, &maskStorageDescriptorSetWrite,
 			0, nullptr);
 	}
 }
 
+// Scene texture is recreated with the swapchain, so only set of the frame that is not in flight is updated.
+void Descriptor::updateSceneTexture(Image& sceneTexture, uint32_t frame)
+{
+	VkDescriptorImageInfo sceneTextureSamplerInfo{};
+	sceneTextureSamplerInfo.imageLayout = sceneTexture.getDetails().layout;
+	sceneTextureSamplerInfo.imageView = sceneTexture.getView();
+
+	if (sampler != VK_NULL_HANDLE) {
+		sceneTextureSamplerInfo.sampler = sampler;
+	}
+
+	VkWriteDescriptorSet sceneTextureDescriptorSetWrite = { VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET };
+	sceneTextureDescriptorSetWrite.dstSet = sets[frame];
+	sceneTextureDescriptorSetWrite.dstBinding = 11;
+	sceneTextureDescriptorSetWrite.dstArrayElement = 0;
+	sceneTextureDescriptorSetWrite.descriptorCount = 1;
+	sceneTextureDescriptorSetWrite.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	sceneTextureDescriptorSetWrite.pImageInfo = &sceneTextureSamplerInfo;
+	vkUpdateDescriptorSets(device, 1, &sceneTextureDescriptorSetWrite,
+		0, nullptr);
+}
+
 void Descriptor::destroy()
 {
 	vkDestroyDescriptorPool(device, pool, nullptr);
@@ -8,8 +8,6 @@
 #include "vulkan/vulkan.h"
 #include <stdexcept>
 
-using Constants::MASKS_COUNT;
-
 class Descriptor {
 
     VkDevice device = VK_NULL_HANDLE;
@@ -20,17 +18,19 @@ class Descriptor {
     std::vector<VkDescriptorSet> sets;
     std::vector<VkDescriptorSet> bindlessSets;
     VkSampler sampler = VK_NULL_HANDLE;
+    VkSampler maskSampler = VK_NULL_HANDLE;
 
 public:
     void create(VkDevice& device,
-                std::vector<UniformBuffer> uniformInstanceBuffers,
+                std::vector<InstanceBuffer>& instanceBuffers,
                 std::vector<UniformBuffer> uniformViewBuffers,
                 Image& paintingTexture, Image& heightMapTexture, Sampler& textureSampler,
-                UniformBuffer& mouseUniform, const std::array<Image, MASKS_COUNT>& selectedPosMasks,
-                UniformBuffer& timeUniform, UniformBuffer& effectParamsUniform, UniformBuffer& lightParamsUniform);
-    void updateBindlessTexture(Image& textureWrite, uint32_t arrayElementId);
+                UniformRingBuffer& frameUniforms, const Image& selectedPosMask, Sampler& maskSampler,
+                Image& noiseTexture, Image& sceneTexture);
+    void updateInstanceBuffer(InstanceBuffer& instanceBuffer, uint32_t frame);
     void updateHeightTexture(Image& heightTexture);
-    void updateMaskTextures(const std::array<Image, MASKS_COUNT>& maskTextures);
+    void updateMaskTexture(const Image& maskTexture);
+    void updateSceneTexture(Image& sceneTexture, uint32_t frame);
     void destroy();
     VkDescriptorSetLayout& getSetLayout();
     VkDescriptorSetLayout& getBindlessSetLayout();
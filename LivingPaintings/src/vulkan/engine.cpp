@@ -1,8 +1,6 @@
 #include "engine.h"
 #include "../utils/path_params.hpp"
 
-using Data::AlignmentProperties;
-using Data::RuntimeProperties;
 using Runtime::PATH_PARAMS;
 
 using Constants::APP_NAME;
@@ -10,10 +8,19 @@ using Constants::WINDOW_WIDTH;
 using Constants::WINDOW_HEIGHT;
 using Constants::IMAGE_TEXTURE_FORMAT;
 using Constants::BUMP_TEXTURE_FORMAT;
-using Constants::EFFECT_MASK_TEXTURE_FORMAT;
 using Constants::MAX_FRAMES_IN_FLIGHT;
 using Constants::OUTPUT_FOLDER_NAME;
+using Constants::PIPELINE_CACHE_FILE_NAME;
 using Constants::EXPORT_FRAME_COUNT;
+using Constants::NOISE_TEXTURE_FORMAT;
+using Constants::NOISE_TEXTURE_SIZE;
+using Constants::NOISE_WORKGROUP_SIZE;
+using Constants::HEIGHT_MAP_COMPUTE_SHADER;
+using Constants::NOISE_COMPUTE_SHADER;
+using Constants::BRUSH_COMPUTE_SHADER;
+using Constants::BRUSH_WORKGROUP_SIZE;
+using Constants::BACKGROUND_TEXTURE_SLOT;
+using Constants::OBJECT_INSTANCES;
 
 using std::chrono::steady_clock;
 using std::chrono::seconds;
@@ -33,6 +40,17 @@ void Engine::run()
 	}
 }
 
+bool Engine::runBenchmark(const std::vector<ScriptedInput>& script)
+{
+	inputScript = script;
+	scriptPosition = 0;
+	replayingScript = true;
+	segmentationSystem.getSelectionLatency().enable();
+	run();
+	segmentationSystem.getSelectionLatency().report(std::cout);
+	return scriptPosition == inputScript.size();
+}
+
 void Engine::init()
 {
 	system(createOutputFolder.c_str());
@@ -57,6 +75,8 @@ void Engine::init()
 		vulkan.sampleCount = maxSampleCount;
 	}
 
+	qualityGovernor.create(device, maxSampleCount);
+
 	inFlightFence.create(vulkan.device, true);
 	imageAvailable.create(vulkan.device);
 	renderFinished.create(vulkan.device);
@@ -76,7 +96,8 @@ void Engine::init()
 	const VkFormat colorFormat = swapchain.getImageFormat();
 	const VkFormat depthFormat = swapchain.getDepthFormat();
 	INIT(vulkan.renderPass, renderPass.create(vulkan.device, colorFormat, depthFormat, vulkan.sampleCount));
-	swapchain.createFramebuffers(vulkan.renderPass);
+	INIT(vulkan.presentRenderPass, presentRenderPass.createPresentPass(vulkan.device, colorFormat));
+	swapchain.createFramebuffers(vulkan.renderPass, vulkan.presentRenderPass);
 
 	Queue& transferQueue = device.getTransferQueue();
 
@@ -87,7 +108,7 @@ void Engine::init()
 		IMAGE_TEXTURE_FORMAT,
 		VK_SHADER_STAGE_FRAGMENT_BIT | VK_SHADER_STAGE_COMPUTE_BIT,
 		VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_ASPECT_COLOR_BIT,
-		VK_SAMPLE_COUNT_1_BIT, {}, 0);
+		VK_SAMPLE_COUNT_1_BIT);
 	paintingTexture.create(vulkan.device, vulkan.physicalDevice, vulkan.commandPool,
 		VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
 		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, transferQueue);
@@ -107,11 +128,22 @@ void Engine::init()
 		VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_STORAGE_BIT,
 		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, transferQueue);
 
+	noiseTexture.imageDetails.createImageInfo(
+		"", NOISE_TEXTURE_SIZE, NOISE_TEXTURE_SIZE, 2, // half float texel takes 2 bytes
+		VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_VIEW_TYPE_2D,
+		NOISE_TEXTURE_FORMAT,
+		VK_SHADER_STAGE_FRAGMENT_BIT | VK_SHADER_STAGE_COMPUTE_BIT,
+		VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_ASPECT_COLOR_BIT,
+		VK_SAMPLE_COUNT_1_BIT);
+	noiseTexture.create(vulkan.device, vulkan.physicalDevice, vulkan.commandPool,
+		VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_STORAGE_BIT,
+		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, transferQueue);
+
 	textureSampler.create(vulkan.device, vulkan.physicalDevice);
+	maskSampler.create(vulkan.device, vulkan.physicalDevice, VK_FILTER_NEAREST);
 
-	size_t minUniformAlignment = device.getProperties().limits.minUniformBufferOffsetAlignment;
-	Data::setUniformDynamicAlignments(minUniformAlignment);
 	Data::GraphicsObject::instanceUniform.allocateInstances();
+	Data::GraphicsObject::instanceUniform.setTextureSlot(0, BACKGROUND_TEXTURE_SLOT);
 
 	graphicsObjects.resize(1);
 	vertexBuffers.resize(1);
@@ -122,10 +154,10 @@ void Engine::init()
 	indexBuffers[0].create(vulkan.device, vulkan.physicalDevice, vulkan.commandPool,
 		graphicsObjects[0].indices, transferQueue);
 
-	instanceUniformBuffers.resize(MAX_FRAMES_IN_FLIGHT);
-	for (UniformBuffer& uniformBuffer : instanceUniformBuffers) {
-		uniformBuffer.create(vulkan.device, vulkan.physicalDevice, RuntimeProperties::uboMemorySize,
-			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT);
+	instanceBuffers.resize(MAX_FRAMES_IN_FLIGHT);
+	for (InstanceBuffer& instanceBuffer : instanceBuffers) {
+		instanceBuffer.create(vulkan.device, vulkan.physicalDevice, OBJECT_INSTANCES,
+			device.getProperties().limits.nonCoherentAtomSize);
 	}
 
 	viewUniformBuffers.resize(MAX_FRAMES_IN_FLIGHT);
@@ -134,36 +166,33 @@ void Engine::init()
 			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
 	}
 
-	time.create(vulkan.device, vulkan.physicalDevice, sizeof(float),
-		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
-
-	effectsParams.create(vulkan.device, vulkan.physicalDevice, sizeof(EffectParams),
-		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
-
-	lightsParams.create(vulkan.device, vulkan.physicalDevice, sizeof(LightParams),
-		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+	// Sizes are listed in the order of Data::FrameUniform.
+	frameUniforms.create(vulkan.device, vulkan.physicalDevice,
+		{ mouseUniformSize, sizeof(float), sizeof(EffectParams), sizeof(LightParams), sizeof(Controls::BrushStroke) },
+		device.getProperties().limits);
 
 	segmentationSystem.init(device, vulkan.commandPool, pWindow,
 		PATH_PARAMS.TEXTURE_PATH, TEX_WIDTH, TEX_HEIGHT,
-		&controls.getMouseControls());
+		gui.getMasksCount(), &controls.getMouseControls());
 
 	controls.fillInMouseControlInfo(glm::uvec2(WINDOW_WIDTH, WINDOW_HEIGHT),
 		0.1f, pWindow);
 
-	mouseControl.create(vulkan.device, vulkan.physicalDevice, mouseUniformSize,
-		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
-
-	descriptor.create(vulkan.device, instanceUniformBuffers,
+	descriptor.create(vulkan.device, instanceBuffers,
 		viewUniformBuffers, paintingTexture,
-		heightMapTexture, textureSampler, mouseControl,
-		segmentationSystem.getSelectedPosMasks(),
-		time, effectsParams, lightsParams);
+		heightMapTexture, textureSampler, frameUniforms,
+		segmentationSystem.getSelectedPosMask(), maskSampler,
+		noiseTexture, swapchain.getSceneImage());
+	bindlessRegistry.create(vulkan.device, descriptor.getBindlessSet(0), textureSampler.get());
+	bindlessRegistry.update(BACKGROUND_TEXTURE_SLOT, paintingTexture);
 
 	std::vector<VkDescriptorSetLayout> descriptorLayouts = { descriptor.getSetLayout(), descriptor.getBindlessSetLayout() };
-	pipeline.create(vulkan.device, vulkan.renderPass, descriptorLayouts,
+	INIT(vulkan.pipelineCache, pipelineCache.create(device, std::filesystem::path(OUTPUT_FOLDER_NAME) / PIPELINE_CACHE_FILE_NAME));
+	pipeline.create(vulkan.device, vulkan.pipelineCache, vulkan.renderPass, vulkan.presentRenderPass, descriptorLayouts,
 		swapchain.getExtent(), vulkan.sampleCount);
 
-	gui.init(vulkan.instance, device, vulkan.commandPool, renderPass, swapchain, descriptor.getPool(), pWindow);
+	// UI is drawn in the present pass at native resolution
+	gui.init(vulkan.instance, device, vulkan.commandPool, presentRenderPass, swapchain, descriptor.getPool(), pWindow);
 
 	FrameExport::setPresentationSurfaceFormat(colorFormat);
 }
@@ -190,11 +219,16 @@ void Engine::update()
 
 	forwardRenderAction.setContext(pipeline, extent, 0);
 
+	// Scene image is recreated with the swapchain, recreation count tells which descriptor sets are outdated.
+	std::vector<uint32_t> sceneTextureRecreationCounts(MAX_FRAMES_IN_FLIGHT, swapchain.getRecreationCount());
+
 	auto runComputeShader = [&](uint currentFrame) {
 		VkCommandBuffer& cmdCompute = computeCmds.get(currentFrame);
 
+		bindlessRegistry.flush(); // height map is computed from the background texture
 		computeCmds.begin(currentFrame);
-		pipeline.bind(cmdCompute, descriptor.getSet(currentFrame), descriptor.getBindlessSet(0));
+		pipeline.bind(cmdCompute, descriptor.getSet(currentFrame), descriptor.getBindlessSet(0),
+			HEIGHT_MAP_COMPUTE_SHADER, currentFrame);
 		vkCmdDispatch(cmdCompute, imageDetails.width,
 			imageDetails.height, 1);
 		computeCmds.end(currentFrame);
@@ -203,26 +237,70 @@ void Engine::update()
 			computeSignalSemaphores, computeWaitStages, currentFrame);
 		};
 
+	// Frame region is written only after fence of the frame is signaled, when GPU no longer reads it.
+	float timeDuration_s = 0.0f;
+	auto updateFrameUniforms = [&](uint currentFrame) {
+		frameUniforms.update(currentFrame, Data::MOUSE_CONTROL_UNIFORM, controls.getMouseControls());
+		frameUniforms.update(currentFrame, Data::TIME_UNIFORM, timeDuration_s);
+		frameUniforms.update(currentFrame, Data::EFFECT_PARAMS_UNIFORM, gui.getEffectParams());
+		frameUniforms.update(currentFrame, Data::LIGHT_PARAMS_UNIFORM, gui.getLightParams());
+		frameUniforms.flush(currentFrame);
+		};
+
+	// Bake noise texture that is used by effects instead of calculating noise for every fragment.
+	float bakedNoiseScale = -1.0f;
+	auto bakeNoiseTexture = [&](uint currentFrame) {
+		VkCommandBuffer& cmdCompute = computeCmds.get(currentFrame);
+		const uint32_t groupCount = (NOISE_TEXTURE_SIZE + NOISE_WORKGROUP_SIZE - 1) / NOISE_WORKGROUP_SIZE;
+
+		inFlightFence.wait(currentFrame);
+		updateFrameUniforms(currentFrame);
+		computeCmds.begin(currentFrame);
+		pipeline.bind(cmdCompute, descriptor.getSet(currentFrame), descriptor.getBindlessSet(0),
+			NOISE_COMPUTE_SHADER, currentFrame);
+		vkCmdDispatch(cmdCompute, groupCount, groupCount, 1);
+		computeCmds.end(currentFrame);
+
+		computeQueue.submit(cmdCompute, inFlightFence, computeWaitSemaphores,
+			computeSignalSemaphores, computeWaitStages, currentFrame);
+		};
+
 	// run compute only once
 	runComputeShader(0);
 
 	while (!glfwWindowShouldClose(pWindow)) {
 		glfwPollEvents();
+		if (replayingScript) {
+			replayInputScript();
+		}
+
+		// Quality is changed between frames, when all submitted frames are completed.
+		const bool exporting = gui.videoExportParams.writeFile;
+		QualityParams& qualityParams = gui.getQualityParams();
+		qualityGovernor.update(qualityParams, exporting);
+		if (qualityParams.autoQuality || exporting) {
+			const QualityGovernor::QualityLevel qualityLevel = qualityGovernor.getQualityLevel(exporting);
+			gui.getRenderParams().renderScale = qualityLevel.renderScale;
+			gui.getEffectParams().parallaxLayers = qualityLevel.parallaxLayers;
+			if (qualityLevel.samples != vulkan.sampleCount) {
+				changeSampleCount(qualityLevel.samples);
+			}
+		}
 
 		steady_clock::time_point currentTime = steady_clock::now();
-		float timeDuration_s = duration<float, seconds::period>(currentTime.time_since_epoch()).count();
-		Controls::MouseControl& mouseControls = controls.getMouseControls();
+		timeDuration_s = duration<float, seconds::period>(currentTime.time_since_epoch()).count();
 		EffectParams& effectParams = gui.getEffectParams();
-		LightParams& lightParams = gui.getLightParams();
 		int16_t maskIndex = gui.getMouseControlParams().maskIndex;
 		glm::dvec2 cursorPos{};
 		glfwGetCursorPos(pWindow, &cursorPos.x, &cursorPos.y);
 		controls.updateMousePos(cursorPos);
 		controls.updateMaskIndex(maskIndex);
-		mouseControl.update(mouseControls);
-		time.update(timeDuration_s);
-		effectsParams.update(effectParams);
-		lightsParams.update(lightParams);
+		segmentationSystem.setBrushParams(gui.getMouseControlParams().brushRadius, gui.getMouseControlParams().brushHardness);
+
+		if (effectParams.noiseScale != bakedNoiseScale) {
+			bakeNoiseTexture(0);
+			bakedNoiseScale = effectParams.noiseScale;
+		}
 
 		segmentationSystem.updatePositionMasks(device, vulkan.commandPool, transferQueue);
 
@@ -277,13 +355,11 @@ void Engine::update()
 				Data::GraphicsObject::instanceUniform.transform(globAnimParams, objectAnimationParams, animationParams);
 			}
 
-			instanceUniformBuffers[currentFrame].update(Data::GraphicsObject::instanceUniform);
-
-			VkMappedMemoryRange mappedMemoryRange{};
-			mappedMemoryRange.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
-			mappedMemoryRange.memory = instanceUniformBuffers[currentFrame].getDeviceMemory();
-			mappedMemoryRange.size = instanceUniformBuffers[currentFrame].getMemorySize();
-			vkFlushMappedMemoryRanges(vulkan.device, 1, &mappedMemoryRange);
+			// Instances written for this frame are uploaded to every frame buffer once its fence is signaled.
+			const auto [dirtyBegin, dirtyEnd] = Data::GraphicsObject::instanceUniform.takeDirtyRange();
+			for (InstanceBuffer& instanceBuffer : instanceBuffers) {
+				instanceBuffer.markDirty(dirtyBegin, dirtyEnd);
+			}
 
 			CameraParams cameraParams = gui.getCameraParams();
 			Data::GraphicsObject::viewUniform.cameraView(cameraParams, extent);
@@ -291,47 +367,107 @@ void Engine::update()
 
 			inFlightFence.wait(currentFrame);
 			inFlightFence.reset(currentFrame);
+			const Controls::BrushStroke brushStroke = segmentationSystem.takeBrushStroke();
+			frameUniforms.update(currentFrame, Data::BRUSH_STROKE_UNIFORM, brushStroke);
+			updateFrameUniforms(currentFrame);
+			if (instanceBuffers[currentFrame].update(Data::GraphicsObject::instanceUniform.instances)) {
+				descriptor.updateInstanceBuffer(instanceBuffers[currentFrame], currentFrame);
+			}
+			qualityGovernor.collectFrameTime(currentFrame);
+			pipeline.releaseFrame(currentFrame);
 
-			swapchain.asquireNextImage(graphicsQueue, vulkan.renderPass,
-				currentImageAvailable, pWindow);
+			swapchain.asquireNextImage(graphicsQueue, currentImageAvailable, pWindow);
+
+			if (sceneTextureRecreationCounts[currentFrame] != swapchain.getRecreationCount()) {
+				descriptor.updateSceneTexture(swapchain.getSceneImage(), currentFrame);
+				sceneTextureRecreationCounts[currentFrame] = swapchain.getRecreationCount();
+			}
 
+			bindlessRegistry.flush();
 			graphicsCmds.begin(currentFrame);
+			qualityGovernor.writeBeginTimestamp(cmdGraphics, currentFrame);
 
-			gui.drawParams.pipelineHistorySize = pipeline.getPipelineHistorySize();
+			gui.drawParams.pipelineIds = pipeline.getPipelineIds();
 			gui.drawParams.imageLoaded = segmentationSystem.isImageLoaded();
+			gui.drawParams.autoSegmentationProgress = segmentationSystem.getAutoSegmentationProgress();
 			if (!gui.videoExportParams.writeFile) {
 				gui.draw();
 			}
 
 			if (pipeline.recreateifShadersChanged()) {
-				gui.selectPipelineindex(pipeline.getPipelineHistorySize() - 1);
+				gui.selectPipelineId(pipeline.getPipelineId(pipeline.getPipelineHistorySize() - 1));
 				runComputeShader(currentFrame);
+				bakeNoiseTexture(currentFrame);
 
 				inFlightFence.wait(currentFrame);
 				inFlightFence.reset(currentFrame);
 			}
 
-			forwardRenderAction.setContext(pipeline, extent, gui.getSelectedPipelineIndex());
+			/* Brush samples of the frame are stamped into the mask before painting samples it. Barrier before
+			   dispatch orders stamping after the mask is read and stamped by previously submitted frames. */
+			if (brushStroke.sampleCount > 0) {
+				VkMemoryBarrier maskBarrier = { VK_STRUCTURE_TYPE_MEMORY_BARRIER };
+				maskBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+				maskBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+				vkCmdPipelineBarrier(cmdGraphics,
+					VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+					VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &maskBarrier, 0, nullptr, 0, nullptr);
+
+				pipeline.bind(cmdGraphics, descriptor.getSet(currentFrame), descriptor.getBindlessSet(0),
+					BRUSH_COMPUTE_SHADER, currentFrame);
+				vkCmdDispatch(cmdGraphics,
+					(brushStroke.boundsSize.x + BRUSH_WORKGROUP_SIZE - 1) / BRUSH_WORKGROUP_SIZE,
+					(brushStroke.boundsSize.y + BRUSH_WORKGROUP_SIZE - 1) / BRUSH_WORKGROUP_SIZE, 1);
+
+				maskBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+				maskBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+				vkCmdPipelineBarrier(cmdGraphics, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+					VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 1, &maskBarrier, 0, nullptr, 0, nullptr);
+			}
+
+			// Painting is rendered to the part of the scene image and upscaled to the swapchain image.
+			const RenderParams& renderParams = gui.getRenderParams();
+			const VkExtent2D renderExtent = {
+				std::max(1u, static_cast<uint32_t>(extent.width * renderParams.renderScale)),
+				std::max(1u, static_cast<uint32_t>(extent.height * renderParams.renderScale))
+			};
+
+			// Selected pipeline that was evicted from history or built for another sample count is replaced by the latest one.
+			const size_t latestPipelineIndex = pipeline.getPipelineHistorySize() - 1;
+			const std::optional<size_t> selectedPipelineIndex = pipeline.findPipelineIndex(gui.getSelectedPipelineId());
+			const size_t pipelineIndex = selectedPipelineIndex && pipeline.isCompatible(*selectedPipelineIndex)
+				? *selectedPipelineIndex : latestPipelineIndex;
+			pipeline.retainForFrame(pipelineIndex, currentFrame);
+			forwardRenderAction.setContext(pipeline, renderExtent, pipelineIndex);
 			forwardRenderAction.beginRenderPass(cmdGraphics, vulkan.renderPass,
-				framebuffers, currentFrame);
+				swapchain.getSceneFramebuffer());
 			for (size_t i = 0; i < graphicsObjects.size(); i++) {
 				forwardRenderAction.recordCommandBuffer(cmdGraphics,
 					descriptor.getSet(currentFrame), descriptor.getBindlessSet(0),
 					vertexBuffers[i], indexBuffers[i], graphicsObjects[i]);
 			}
+			forwardRenderAction.endRenderPass(cmdGraphics);
+
+			upscaleRenderAction.setContext(pipeline, extent, renderExtent, renderParams.sharpness);
+			upscaleRenderAction.beginRenderPass(cmdGraphics, vulkan.presentRenderPass,
+				framebuffers, currentFrame);
+			upscaleRenderAction.recordCommandBuffer(cmdGraphics,
+				descriptor.getSet(currentFrame), descriptor.getBindlessSet(0));
 
 			if (!gui.videoExportParams.writeFile) {
 				gui.renderDrawData(cmdGraphics);
 			}
 
-			forwardRenderAction.endRenderPass(cmdGraphics);
+			upscaleRenderAction.endRenderPass(cmdGraphics);
+			qualityGovernor.writeEndTimestamp(cmdGraphics, currentFrame);
 			graphicsCmds.end(currentFrame);
 
 			presentationQueue.submit(cmdGraphics, inFlightFence, waitSemaphores,
 				signalSemaphores, waitStages, currentFrame);
 
-			swapchain.presentImage(graphicsQueue, vulkan.renderPass, presentationQueue.get(),
+			swapchain.presentImage(graphicsQueue, presentationQueue.get(),
 				signalSemaphores, pWindow);
+			segmentationSystem.getSelectionLatency().framePresented();
 
 			if (gui.videoExportParams.writeFile) {
 				std::shared_ptr<uchar> frame = swapchain.writeFrameToBuffer(cmdGraphics, transferQueue, currentFrame);
@@ -349,11 +485,15 @@ void Engine::update()
 
 		if (gui.drawParams.constructSelectedObject) {
 			Data::GraphicsObject constructedObject;
-			std::shared_ptr<uchar> spSelectedPosMask = segmentationSystem.getSelectedPositionsMask(0);
-			segmentationSystem.removeAllMaskPositions(0);
+			// Pixels stamped by brush are read back before the mask is copied.
+			vkDeviceWaitIdle(vulkan.device);
+			segmentationSystem.syncBrushStrokes(transferQueue);
 			ObjectConstructionParams objectConstructionParams = gui.getObjectConstructionParams();
-			constructedObject.constructMeshFromTexture(objectsTextures[0].imageDetails.width, objectsTextures[0].imageDetails.height, 0.001f, spSelectedPosMask.get(),
-				objectConstructionParams.alphaPercentage);
+			segmentationSystem.withSelectedPositionsMask(0, [&](const uchar* selectedPosMask) {
+				constructedObject.constructMeshFromTexture(objectsTextures[0].imageDetails.width, objectsTextures[0].imageDetails.height, 0.001f, selectedPosMask,
+					objectConstructionParams.alphaPercentage);
+			});
+			segmentationSystem.removeAllMaskPositions(0);
 
 			if (constructedObject.indices.size() > 0) {
 				size_t lastSize = graphicsObjects.size();
@@ -365,13 +505,17 @@ void Engine::update()
 				indexBuffers[lastSize].create(
 					vulkan.device, vulkan.physicalDevice, vulkan.commandPool,
 					constructedObject.indices, transferQueue);
+				// Object keeps the background it was cut from, background slot is then replaced by inpainted image.
+				constructedObject.textureSlot = bindlessRegistry.allocate(objectsTextures.back());
+				Data::GraphicsObject::instanceUniform.setTextureSlot(constructedObject.instanceId, constructedObject.textureSlot);
 				graphicsObjects.push_back(constructedObject);
 
 				InpaintingParams inpaintingParams = gui.getInpaintingParams();
 				gui.createGraphicsObjectParams(constructedObject.instanceId);
 				if (inpaintingParams.enableInpainting) {
-					segmentationSystem.inpaintImage(inpaintingParams.patchSize, objectsTextures, descriptor,
+					segmentationSystem.inpaintImage(inpaintingParams.patchSize, objectsTextures,
 						vulkan.commandPool, transferQueue);
+					bindlessRegistry.update(BACKGROUND_TEXTURE_SLOT, objectsTextures.back());
 
 					runComputeShader(0);
 				}
@@ -389,6 +533,7 @@ void Engine::update()
 				vertexBuffers[i].destroy();
 				indexBuffers[i].destroy();
 				if (i > 0) {
+					bindlessRegistry.release(graphicsObjects[i].textureSlot);
 					vertexBuffers.erase(vertexBuffers.begin() + i);
 					indexBuffers.erase(indexBuffers.begin() + i);
 					graphicsObjects.erase(graphicsObjects.begin() + i);
@@ -420,14 +565,14 @@ void Engine::update()
 				IMAGE_TEXTURE_FORMAT,
 				VK_SHADER_STAGE_FRAGMENT_BIT | VK_SHADER_STAGE_COMPUTE_BIT,
 				VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_ASPECT_COLOR_BIT,
-				VK_SAMPLE_COUNT_1_BIT, {}, 0);
+				VK_SAMPLE_COUNT_1_BIT);
 			loadedPaintingTexture.create(vulkan.device, vulkan.physicalDevice, vulkan.commandPool,
 				VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
 				VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, transferQueue);
 			width = loadedPaintingTexture.imageDetails.width;
 			height = loadedPaintingTexture.imageDetails.height;
 			objectsTextures.push_back(loadedPaintingTexture);
-			descriptor.updateBindlessTexture(loadedPaintingTexture, 0);
+			bindlessRegistry.update(BACKGROUND_TEXTURE_SLOT, loadedPaintingTexture);
 
 			heightMapTexture.destroy();
 			heightMapTexture.imageDetails.createImageInfo(
@@ -445,11 +590,11 @@ void Engine::update()
 			// better to swap images
 			segmentationSystem.destroy();
 			segmentationSystem.init(device, vulkan.commandPool, pWindow,
-				filePath.c_str(), width, height, &controls.getMouseControls());
-			const std::array<Image, MASKS_COUNT> spSelectedPosMasks = segmentationSystem.getSelectedPosMasks();
-			descriptor.updateMaskTextures(spSelectedPosMasks);
+				filePath.c_str(), width, height, gui.getMasksCount(), &controls.getMouseControls());
+			descriptor.updateMaskTexture(segmentationSystem.getSelectedPosMask());
 
 			Data::GraphicsObject::instanceUniform.allocateInstances();
+			Data::GraphicsObject::instanceUniform.setTextureSlot(0, BACKGROUND_TEXTURE_SLOT);
 
 			graphicsObjects.resize(1);
 			vertexBuffers.resize(1);
@@ -472,17 +617,22 @@ void Engine::cleanup()
 
 	gui.destroy();
 
+	qualityGovernor.destroy();
 	inFlightFence.destroy();
 	imageAvailable.destroy();
 	renderFinished.destroy();
 
 	pipeline.destroy();
+	pipelineCache.save();
+	pipelineCache.destroy();
 	descriptor.destroy();
 	textureSampler.destroy();
+	maskSampler.destroy();
 	for (size_t i = 0; i < objectsTextures.size(); i++) {
 		objectsTextures[i].destroy();
 	}
 	heightMapTexture.destroy();
+	noiseTexture.destroy();
 
 	Data::GraphicsObject::instanceUniform.destroy();
 	for (size_t i = 0; i < graphicsObjects.size(); i++) {
@@ -491,14 +641,12 @@ void Engine::cleanup()
 	}
 
 	for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
-		instanceUniformBuffers[i].destroy();
+		instanceBuffers[i].destroy();
 		viewUniformBuffers[i].destroy();
 	}
-	lightsParams.destroy();
-	effectsParams.destroy();
-	time.destroy();
-	mouseControl.destroy();
+	frameUniforms.destroy();
 	renderPass.destroy();
+	presentRenderPass.destroy();
 	commandPool.destroy();
 	swapchain.destroy();
 
@@ -513,11 +661,50 @@ void Engine::cleanup()
 	glfwTerminate();
 }
 
+/* Sample count of the painting pass is a part of render pass, attachments and graphics pipeline,
+   so all of them are recreated. Called only when there is no work submitted to the device. */
+void Engine::changeSampleCount(const VkSampleCountFlagBits sampleCount)
+{
+	vkDeviceWaitIdle(vulkan.device);
+	vulkan.sampleCount = sampleCount;
+
+	pipeline.releaseRenderPass();
+	renderPass.destroy();
+	INIT(vulkan.renderPass, renderPass.create(vulkan.device, swapchain.getImageFormat(),
+		swapchain.getDepthFormat(), vulkan.sampleCount));
+	swapchain.changeSampleCount(device.getGraphicsQueue(), pWindow, vulkan.sampleCount, vulkan.renderPass);
+	pipeline.changeSampleCount(vulkan.renderPass, vulkan.sampleCount);
+	gui.selectPipelineId(pipeline.getPipelineId(pipeline.getPipelineHistorySize() - 1));
+}
+
+/* Next input is replayed after selection of the previous one is shown, so prompts are not coalesced and every
+   selection is measured on its own. Script starts after automatic segmentation is finished, so it does not
+   share the model with the job. Script is stopped when painting is not loaded into the model. */
+void Engine::replayInputScript()
+{
+	if (!segmentationSystem.isImageLoaded() || !segmentationSystem.isAutoSegmentationFinished()
+		|| !segmentationSystem.isSelectionSettled()) {
+		return;
+	}
+	if (!segmentationSystem.isImageEmbeddingLoaded()) {
+		std::cerr << "Script is stopped, painting is not loaded into the segmentation model" << '\n';
+		glfwSetWindowShouldClose(pWindow, GLFW_TRUE);
+		return;
+	}
+	if (scriptPosition == inputScript.size()) {
+		glfwSetWindowShouldClose(pWindow, GLFW_TRUE);
+		return;
+	}
+	segmentationSystem.replayInput(inputScript[scriptPosition]);
+	scriptPosition++;
+}
+
 void Engine::initWindow(const uint16_t width, const uint16_t height)
 {
 	glfwInit();
 	glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
 	glfwWindowHint(GLFW_DOUBLEBUFFER, GLFW_TRUE);
+	glfwWindowHint(GLFW_VISIBLE, replayingScript ? GLFW_FALSE : GLFW_TRUE);
 	pWindow = glfwCreateWindow(width, height, APP_NAME, nullptr, nullptr);
 	glfwSetWindowUserPointer(pWindow, this);
 	glfwMakeContextCurrent(pWindow);
@@ -1,5 +1,6 @@
 #pragma once
 #include "../segmentation/segmentation_system.h"
+#include "bindless_registry.h"
 #include "command_buffer.h"
 #include "command_pool.h"
 #include "consts.h"
@@ -12,11 +13,14 @@
 #include "image.h"
 #include "instance.h"
 #include "pipeline.h"
+#include "pipeline_cache.h"
+#include "quality_governor.h"
 #include "queue_family.h"
 #include "render_pass.h"
 #include "sampler.h"
 #include "semaphore.h"
 #include "surface.h"
+#include "upscale_rendering_action.h"
 #include "../utils/frame_exporter.h"
 #include "../utils/win_utils.cpp"
 #include "vulkan/vulkan.h"
@@ -49,7 +53,9 @@ class Engine {
         VkSurfaceKHR surface = VK_NULL_HANDLE;
         VkPhysicalDevice physicalDevice = VK_NULL_HANDLE;
         VkDevice device = VK_NULL_HANDLE;
+        VkPipelineCache pipelineCache = VK_NULL_HANDLE;
         VkRenderPass renderPass = VK_NULL_HANDLE;
+        VkRenderPass presentRenderPass = VK_NULL_HANDLE;
         VkCommandPool commandPool = VK_NULL_HANDLE;
         VkSampleCountFlagBits sampleCount = MAX_SAMPLE_COUNT;
     } vulkan;
@@ -63,36 +69,48 @@ class Engine {
     Surface surface;
     Swapchain swapchain;
     Pipeline pipeline;
+    PipelineCache pipelineCache;
     RenderPass renderPass;
+    RenderPass presentRenderPass;
     CommandPool commandPool;
     CommandBuffer graphicsCmds;
     CommandBuffer computeCmds;
     ForwardRenderingAction forwardRenderAction;
+    UpscaleRenderingAction upscaleRenderAction;
+    QualityGovernor qualityGovernor;
     Semaphore imageAvailable;
     Semaphore renderFinished;
     Fence inFlightFence;
     Descriptor descriptor;
+    BindlessRegistry bindlessRegistry;
     std::vector<Data::GraphicsObject> graphicsObjects;
-    std::vector<UniformBuffer> instanceUniformBuffers;
+    std::vector<InstanceBuffer> instanceBuffers;
     std::vector<UniformBuffer> viewUniformBuffers;
     std::vector<VertexBuffer> vertexBuffers;
     std::vector<IndexBuffer> indexBuffers;
     Controls controls;
-    UniformBuffer mouseControl;
-    UniformBuffer time;
-    UniformBuffer effectsParams;
-    UniformBuffer lightsParams;
+    UniformRingBuffer frameUniforms; // mouse controls, time, effect and light params of every frame in flight
     std::vector<Image> objectsTextures; // contains original image of a painting and inpainted images
     Image heightMapTexture;
+    Image noiseTexture;
     Sampler textureSampler;
+    Sampler maskSampler;
     Gui gui;
     SpecificDrawParams drawParams;
+    std::vector<ScriptedInput> inputScript;
+    size_t scriptPosition = 0;
+    bool replayingScript = false; // window is hidden and closed after the script is replayed
 
     void init();
     void update();
     void cleanup();
+    void changeSampleCount(const VkSampleCountFlagBits sampleCount);
     void initWindow(const uint16_t width, const uint16_t height);
+    void replayInputScript();
 
 public:
     void run();
+    /* Runs until every input of the script is replayed and its selection is shown, latency of stages is printed.
+       Returns false when window is closed before the whole script is replayed. */
+    bool runBenchmark(const std::vector<ScriptedInput>& script);
 };
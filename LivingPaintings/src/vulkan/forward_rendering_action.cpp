@@ -16,14 +16,13 @@ void ForwardRenderingAction::setContext(Pipeline& pipeline,
 
 void ForwardRenderingAction::beginRenderPass(
     VkCommandBuffer& cmdGraphics, VkRenderPass& renderPass,
-    std::vector<VkFramebuffer>& framebuffers,
-    uint32_t currentFrame)
+    VkFramebuffer& framebuffer)
 {
 
     VkRenderPassBeginInfo renderPassBegin {};
     renderPassBegin.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
     renderPassBegin.renderPass = renderPass;
-    renderPassBegin.framebuffer = framebuffers[currentFrame];
+    renderPassBegin.framebuffer = framebuffer;
     renderPassBegin.renderArea.offset = { 0, 0 };
     renderPassBegin.renderArea.extent = extent;
     renderPassBegin.clearValueCount = static_cast<uint32_t>(clearColors.size());
@@ -43,7 +42,6 @@ void ForwardRenderingAction::recordCommandBuffer(VkCommandBuffer& commandBuffer,
     IndexBuffer& indexBuffer,
     Data::GraphicsObject& graphicsObject)
 {
-    const uint32_t dynamicOffset = graphicsObject.instanceId * static_cast<uint32_t>(Data::AlignmentProperties::dynamicUniformAlignment_mat4);
     const VkBuffer vertexBuffers[] = { vertexBuffer.get() };
     const VkDeviceSize offsets[] = { 0 };
     vkCmdBindVertexBuffers(commandBuffer, 0, 1, vertexBuffers, offsets);
@@ -65,7 +63,7 @@ void ForwardRenderingAction::recordCommandBuffer(VkCommandBuffer& commandBuffer,
 
     vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS,
         graphicsPipelineLayout, 0, 1, &descriptorSet,
-        1, &dynamicOffset);
+        0, nullptr);
 
     vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS,
         graphicsPipelineLayout, 1, 1, &bindlessDescriptorSet,
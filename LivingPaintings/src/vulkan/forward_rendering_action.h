@@ -21,8 +21,7 @@ public:
     void setContext(Pipeline& pipeline, VkExtent2D extent, size_t selectedPipelineIndex);
     void beginRenderPass(VkCommandBuffer& cmdGraphics,
         VkRenderPass& renderPass,
-        std::vector<VkFramebuffer>& framebuffers,
-        uint32_t currentFrame);
+        VkFramebuffer& framebuffer);
     void recordCommandBuffer(VkCommandBuffer& commandBuffer,
         VkDescriptorSet& descriptorSet,
         VkDescriptorSet& bindlessDescriptorSet,
@@ -3,7 +3,6 @@
 
 using Constants::APP_NAME;
 using Constants::MAX_FRAMES_IN_FLIGHT;
-using Constants::EFFECTS_COUNT;
 using Constants::STREAM_FRAME_RATE;
 
 const float PAD = 10.0f;
@@ -11,8 +10,11 @@ const ImGuiWindowFlags window_flags = ImGuiWindowFlags_NoDecoration | ImGuiWindo
 
 void Gui::init(VkInstance& instance, Device& _device, VkCommandPool& commandPool, RenderPass& renderPass, Swapchain& swapChain, VkDescriptorPool& descriptorPool, GLFWwindow* pWindow)
 {
-    for (uint16_t maskIndex = 0; maskIndex < EFFECTS_ENABLED_SIZE; maskIndex++) {
-        effectsParams.enabledEffects[maskIndex] = glm::uvec4(1);
+    static_assert(Constants::EFFECT_IDS_COUNT <= Constants::MAX_EFFECT_IDS, "Effect masks do not fit into uvec4.");
+    effectsParams.masksCount = getMasksCount();
+    for (uint16_t effectIndex = 0; effectIndex < effects.size(); effectIndex++) {
+        effectsParams.effectMasks[effects[effectIndex].id] = effectIndex + 1;
+        effectsParams.enabledEffects |= 1u << effectIndex;
     }
 
     Queue& graphicsQueue = _device.getGraphicsQueue();
@@ -66,6 +68,11 @@ void Gui::ShowEventsOverlay(bool* p_open) const
     if (ImGui::Begin("Events", p_open, window_flags)) {
         if (drawParams.imageLoaded) {
             ImGui::Text("Image is loaded!");
+            if (drawParams.autoSegmentationProgress < 1.0f) {
+                ImGui::Text("Finding objects: %d%%", static_cast<int>(drawParams.autoSegmentationProgress * 100.0f));
+            } else {
+                ImGui::Text("Objects are found, click selects them instantly.");
+            }
         } else {
             ImGui::Text("Loading image for segmentation... Cant select objects right now.");
         }
@@ -97,6 +104,8 @@ void Gui::ShowControls(bool* p_open)
         ImGui::Text("Constrols: ");
         ImGui::Separator();
         ImGui::Text("Ctrl + Left Mouse Click: Select object region");
+        ImGui::Text("Ctrl + Left Mouse Drag: Select object region in the box");
+        ImGui::Text("Ctrl + Shift(or Alt) + Left Mouse Click: Add(or exclude) point of the last selected region");
         ImGui::Text("Ctrl + Right Mouse Click: Unselect object region");
         ImGui::Text("I: Zoom in. In zoom in state hold mouse button to select(or unselect) the pixels and release the button when done.");
         ImGui::Text("Note: Change mask index to select area for effects.");
@@ -152,7 +161,9 @@ void Gui::draw()
             drawParams.clearSelectedMask = true;
         }
         ImGui::SameLine();
-        ImGui::DragInt("Mask Index", &mouseControlParams.maskIndex, 1, 0, EFFECTS_COUNT);
+        ImGui::DragInt("Mask Index", &mouseControlParams.maskIndex, 1, 0, getMasksCount() - 1);
+        ImGui::SliderFloat("Brush Radius", &mouseControlParams.brushRadius, 0.5f, MAX_BRUSH_RADIUS);
+        ImGui::SliderFloat("Brush Hardness", &mouseControlParams.brushHardness, 0.0f, 1.0f);
         ImGui::Spacing();
 
         ImGuiTabBarFlags tab_bar_flags = ImGuiTabBarFlags_None;
@@ -305,11 +316,9 @@ void Gui::draw()
                 ImGui::SeparatorText("Effects");
                 ImGui::CheckboxFlags("Highlight selected pixels", &effectsParams.highlightSelectedPixels, 1);
                 ImGui::Separator();
-                for (uint16_t maskIndex = 0; maskIndex < EFFECTS_COUNT; maskIndex++) {
-                    uint16_t vecIndex = maskIndex / 4;
-                    uint16_t vecMaskIndex = maskIndex - vecIndex * 4;
-                    std::string effectCheckboxName = "Effect: " + std::to_string(maskIndex + 1);
-                    ImGui::CheckboxFlags(effectCheckboxName.c_str(), &effectsParams.enabledEffects[vecIndex][vecMaskIndex], 1);
+                for (uint16_t effectIndex = 0; effectIndex < effects.size(); effectIndex++) {
+                    std::string effectCheckboxName = "Effect " + std::to_string(effectIndex + 1) + ": " + effects[effectIndex].name;
+                    ImGui::CheckboxFlags(effectCheckboxName.c_str(), &effectsParams.enabledEffects, 1u << effectIndex);
                 }
                 ImGui::DragFloat("Height Range", &effectsParams.heightRange, 0.01f, 0.1, 2.0f);
                 ImGui::DragFloat("Noise Scale", &effectsParams.noiseScale, 1.0f, 0.01f, 1000.0f);
@@ -319,15 +328,26 @@ void Gui::draw()
                 ImGui::DragFloat("Flickering Light", &effectsParams.amplifyFlickeringLight, 0.01f, 0.0001, 1.0f);
                 ImGui::DragFloat("Highlight", &effectsParams.amplifyHighlight, 0.01f, 0.0001, 1.0f);
 
+                ImGui::SeparatorText("Rendering");
+                ImGui::Checkbox("Auto Quality", &qualityParams.autoQuality);
+                ImGui::DragFloat("Frame Budget (ms)", &qualityParams.frameBudget_ms, 0.1f, 4.0f, 100.0f);
+                ImGui::Text("GPU frame time: %.2f ms, quality level: %d", qualityParams.gpuFrameTime_ms, qualityParams.qualityLevel);
+                // Knobs are driven by quality governor while auto quality is enabled.
+                ImGui::BeginDisabled(qualityParams.autoQuality);
+                ImGui::SliderFloat("Render Scale", &renderParams.renderScale, MIN_RENDER_SCALE, MAX_RENDER_SCALE);
+                ImGui::SliderFloat("Parallax Layers", &effectsParams.parallaxLayers, MIN_PARALLAX_LAYERS, MAX_PARALLAX_LAYERS);
+                ImGui::EndDisabled();
+                ImGui::SliderFloat("Sharpness", &renderParams.sharpness, 0.0f, 1.0f);
+
                 ImGui::EndTabItem();
             }
             if (ImGui::BeginTabItem("Pipeline History"))
             {   
                 // TODO Creating 2 items. Must be only one.
-                for (size_t i = 0; i < drawParams.pipelineHistorySize; i++) {
-                    std::string name = "Graphics Pipeline " + std::to_string(i);
-                    if (ImGui::Selectable(name.c_str(), i == selectedPipelineIndex)) {
-                        selectedPipelineIndex = i;
+                for (const uint32_t pipelineId : drawParams.pipelineIds) {
+                    std::string name = "Graphics Pipeline " + std::to_string(pipelineId);
+                    if (ImGui::Selectable(name.c_str(), pipelineId == selectedPipelineId)) {
+                        selectedPipelineId = pipelineId;
                     }
                 }
                 ImGui::EndTabItem();
@@ -410,6 +430,16 @@ LightParams& Gui::getLightParams()
     return lightParams;
 }
 
+RenderParams& Gui::getRenderParams()
+{
+    return renderParams;
+}
+
+QualityParams& Gui::getQualityParams()
+{
+    return qualityParams;
+}
+
 ObjectConstructionParams& Gui::getObjectConstructionParams()
 {
     return objectConstructionParams;
@@ -425,12 +455,18 @@ InpaintingParams& Gui::getInpaintingParams()
     return inpaintingParams;
 }
 
-size_t Gui::getSelectedPipelineIndex() const
+uint16_t Gui::getMasksCount() const
+{
+    // one mask for object selection and one mask for every effect
+    return static_cast<uint16_t>(effects.size() + 1);
+}
+
+uint32_t Gui::getSelectedPipelineId() const
 {
-    return selectedPipelineIndex;
+    return selectedPipelineId;
 }
 
-void Gui::selectPipelineindex(const size_t pipelineIndex)
+void Gui::selectPipelineId(const uint32_t pipelineId)
 {
-    selectedPipelineIndex = pipelineIndex;
+    selectedPipelineId = pipelineId;
 }
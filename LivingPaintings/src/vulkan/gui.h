@@ -20,9 +20,18 @@
 #include "../vulkan/render_pass.h"
 #include "../vulkan/swapchain.h"
 
-using Constants::MASKS_COUNT;
+using Constants::DEFAULT_EFFECTS;
+using Constants::Effect;
 using Constants::DEFAULT_PATCH_SIZE;
 using Constants::EXPORT_FRAME_COUNT;
+using Constants::MIN_RENDER_SCALE;
+using Constants::MAX_RENDER_SCALE;
+using Constants::DEFAULT_FRAME_BUDGET_MS;
+using Constants::MIN_PARALLAX_LAYERS;
+using Constants::MAX_PARALLAX_LAYERS;
+using Constants::DEFAULT_BRUSH_RADIUS;
+using Constants::DEFAULT_BRUSH_HARDNESS;
+using Constants::MAX_BRUSH_RADIUS;
 
 class Gui {
 
@@ -65,14 +74,17 @@ class Gui {
 	};
 
 	EffectParams effectsParams = {
-		{},
+		{ 0, 0, 0, 0 },
+		0,
 		true,
+		0,
 		1.0f,
 		50.0f,
 		0.005f,
 		0.003f,
 		0.4f,
-		0.2f
+		0.2f,
+		50.0f
 	};
 
 	LightParams lightParams = {
@@ -80,12 +92,26 @@ class Gui {
 		0.35f
 	};
 
+	RenderParams renderParams = {
+		1.0f,
+		0.5f
+	};
+
+	QualityParams qualityParams = {
+		false,
+		DEFAULT_FRAME_BUDGET_MS,
+		0.0f,
+		0
+	};
+
 	ObjectConstructionParams objectConstructionParams = {
 		1
 	};
 
 	MouseControlParams mouseControlParams = {
-		0 // 0 to use object selection mask, other non-negative number select masks for effects.
+		0, // 0 to use object selection mask, other non-negative number select masks for effects.
+		DEFAULT_BRUSH_RADIUS,
+		DEFAULT_BRUSH_HARDNESS
 	};
 
 	InpaintingParams inpaintingParams = {
@@ -93,7 +119,10 @@ class Gui {
 		DEFAULT_PATCH_SIZE
 	};
 
-	size_t selectedPipelineIndex = 0;
+	std::vector<Effect> effects = DEFAULT_EFFECTS;
+
+	// Oldest sets are evicted and reused sets are moved in history, so selection is kept by id.
+	uint32_t selectedPipelineId = 0;
 
 	VkDevice device = VK_NULL_HANDLE;
 	VkCommandPool commandPool = VK_NULL_HANDLE;
@@ -105,7 +134,7 @@ public:
 	std::vector<ObjectParams> objectsAnimationParams{ objectParams };
 	std::vector<AnimationParams> animationControlParams{ animationParams };
 
-	SpecificDrawParams drawParams = { false, 1, false, false, false };
+	SpecificDrawParams drawParams = { false, {}, false, 0.0f, false, false };
 	VideoExportParams videoExportParams = { false, "", EXPORT_FRAME_COUNT };
 
 	uint16_t animIndex = 0;
@@ -128,9 +157,12 @@ public:
 	CameraParams& getCameraParams();
 	EffectParams& getEffectParams();
 	LightParams& getLightParams();
+	RenderParams& getRenderParams();
+	QualityParams& getQualityParams();
 	ObjectConstructionParams& getObjectConstructionParams();
 	MouseControlParams& getMouseControlParams();
 	InpaintingParams& getInpaintingParams();
-	size_t getSelectedPipelineIndex() const;
-	void selectPipelineindex(const size_t pipelineIndex);
+	uint16_t getMasksCount() const;
+	uint32_t getSelectedPipelineId() const;
+	void selectPipelineId(const uint32_t pipelineId);
 };
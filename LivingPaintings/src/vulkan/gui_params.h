@@ -9,10 +9,6 @@
 #ifndef GUI_PARAMS_H
 #define GUI_PARAMS_H
 
-using Constants::EFFECTS_COUNT;
-
-static const uint16_t EFFECTS_ENABLED_SIZE = (EFFECTS_COUNT + 3) / 4;
-
 struct ObjectParams {
 	uint16_t index = 0;
 	float position[3];
@@ -41,14 +37,17 @@ struct GlobalAnimationParams {
 
 struct EffectParams
 {
-	glm::uvec4 enabledEffects[EFFECTS_ENABLED_SIZE]; // boolean values packed into uvec4
-	unsigned int highlightSelectedPixels; // uint aligned to 16 bytes
+	unsigned int effectMasks[Constants::MAX_EFFECT_IDS]; // mask index of every effect id, 0 when effect is not in the set
+	unsigned int enabledEffects; // bit per effect, same order as mask bit planes starting from mask 1
+	unsigned int highlightSelectedPixels;
+	unsigned int masksCount;
 	float heightRange;
 	float noiseScale;
 	float distortionModifier;
 	float parallaxHeightScale;
 	float amplifyFlickeringLight;
 	float amplifyHighlight;
+	float parallaxLayers; // number of ray-marching layers of parallax occlusion mapping
 };
 
 struct CameraParams {
@@ -68,10 +67,23 @@ struct LightParams {
 	float surfaceColorModifier;
 };
 
+struct RenderParams {
+	float renderScale; // fraction of the swapchain extent that painting is rendered at
+	float sharpness; // strength of sharpening applied after upscale, 0 is plain bilinear upscale
+};
+
+struct QualityParams {
+	bool autoQuality; // quality governor adjusts render scale, parallax layers and MSAA
+	float frameBudget_ms;
+	float gpuFrameTime_ms; // last measured GPU time of the graphics command buffer
+	int qualityLevel;
+};
+
 struct SpecificDrawParams {
 	bool paintingTextureLoaded;
-	size_t pipelineHistorySize;
+	std::vector<uint32_t> pipelineIds; // history from the oldest set, items are named and selected by id
 	bool imageLoaded;
+	float autoSegmentationProgress; // from 0 to 1, objects are selected without decoder when it is 1
 	bool constructSelectedObject;
 	bool clearSelectedMask;
 };
@@ -91,6 +103,8 @@ struct ObjectConstructionParams {
 struct MouseControlParams
 {
 	int maskIndex;
+	float brushRadius; // in image pixels
+	float brushHardness;
 };
 
 struct InpaintingParams {
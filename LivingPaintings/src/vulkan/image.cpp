@@ -3,16 +3,13 @@
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"
 
-std::map<uint16_t, uint16_t> Image::bindingIdToImageArrayElementId = {};
-uint32_t Image::Details::imageId = 1000;
-
 void Image::Details::createImageInfo(
 
     const char* filePath,
     uint16_t width, uint16_t height, uint8_t channels,
     VkImageLayout imageLayout, VkImageViewType viewType, VkFormat format,
     int stageUsage, VkImageTiling tiling, int aspectFlags,
-    VkSampleCountFlagBits samples, stbi_uc* pixels, uint32_t bindingId)
+    VkSampleCountFlagBits samples, stbi_uc* pixels)
 {
 
     this->filePath = filePath;
@@ -28,13 +25,6 @@ void Image::Details::createImageInfo(
     this->samples = samples;
     this->pixels = pixels;
     this->bufferSize = width * height * channels;
-    this->bindingId = bindingId;
-    if (bindingIdToImageArrayElementId.contains(bindingId)) {
-        bindingIdToImageArrayElementId.insert({ bindingId, bindingIdToImageArrayElementId[bindingId]++});
-    }
-    else {
-        bindingIdToImageArrayElementId.insert({ bindingId, 0 });
-    }
 }
 
 void Image::create(VkDevice& device, VkPhysicalDevice& physicalDevice, 
@@ -293,6 +283,78 @@ void Image::copyBufferToImage(Queue& queue, unsigned char* buffer, uint32_t bufI
     imageDetails.height = bufImageHeight;
 }
 
+/* Method copies rectangle of texels into the image. Buffer has texels of the whole image, only rows of
+   the rectangle are gathered into staging buffer. */
+void Image::copyBufferRegionToImage(Queue& queue, const unsigned char* buffer, VkOffset2D offset, VkExtent2D extent)
+{
+    const size_t rowSize = static_cast<size_t>(extent.width) * imageDetails.channels;
+    std::vector<unsigned char> regionTexels(rowSize * extent.height);
+    for (uint32_t row = 0; row < extent.height; row++) {
+        const size_t texelOffset = (static_cast<size_t>(offset.y + row) * imageDetails.width + offset.x) * imageDetails.channels;
+        memcpy(regionTexels.data() + row * rowSize, buffer + texelOffset, rowSize);
+    }
+
+    StagingBuffer regionBuffer;
+    regionBuffer.create(device, physicalDevice, regionTexels.data(), regionTexels.size());
+
+    VkCommandBuffer cmd = CommandBuffer::beginSingleTimeCommands(device, commandPool);
+
+    VkBufferImageCopy region {};
+    region.bufferOffset = 0;
+    region.bufferRowLength = 0;
+    region.bufferImageHeight = 0;
+
+    region.imageSubresource.aspectMask = imageDetails.aspectFlags;
+    region.imageSubresource.mipLevel = 0;
+    region.imageSubresource.baseArrayLayer = 0;
+    region.imageSubresource.layerCount = 1;
+
+    region.imageOffset = { offset.x, offset.y, 0 };
+    region.imageExtent = { extent.width, extent.height, 1 };
+
+    vkCmdCopyBufferToImage(cmd, regionBuffer.get(), textureImage, imageDetails.layout, 1, &region);
+
+    CommandBuffer::endSingleTimeCommands(device, commandPool, cmd, queue);
+
+    regionBuffer.destroy();
+}
+
+void Image::copyImageRegionToBuffer(Queue& queue, VkOffset2D offset, VkExtent2D extent, std::vector<unsigned char>& regionTexels)
+{
+    regionTexels.resize(static_cast<size_t>(extent.width) * extent.height * imageDetails.channels);
+
+    Buffer regionBuffer;
+    regionBuffer.create(device, physicalDevice, regionTexels.size(),
+        VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_SHARING_MODE_EXCLUSIVE,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+
+    VkCommandBuffer cmd = CommandBuffer::beginSingleTimeCommands(device, commandPool);
+
+    VkBufferImageCopy region {};
+    region.bufferOffset = 0;
+    region.bufferRowLength = 0;
+    region.bufferImageHeight = 0;
+
+    region.imageSubresource.aspectMask = imageDetails.aspectFlags;
+    region.imageSubresource.mipLevel = 0;
+    region.imageSubresource.baseArrayLayer = 0;
+    region.imageSubresource.layerCount = 1;
+
+    region.imageOffset = { offset.x, offset.y, 0 };
+    region.imageExtent = { extent.width, extent.height, 1 };
+
+    vkCmdCopyImageToBuffer(cmd, textureImage, imageDetails.layout, regionBuffer.get(), 1, &region);
+
+    CommandBuffer::endSingleTimeCommands(device, commandPool, cmd, queue);
+
+    void* data;
+    vkMapMemory(device, regionBuffer.getDeviceMemory(), 0, regionTexels.size(), 0, &data);
+    memcpy(regionTexels.data(), data, regionTexels.size());
+    vkUnmapMemory(device, regionBuffer.getDeviceMemory());
+
+    regionBuffer.destroy();
+}
+
 void Image::createImageView()
 {
     VkImageViewCreateInfo imageViewInfo {};
@@ -20,11 +20,7 @@ class Image {
                           VkPipelineStageFlags destinationStage);
 
 public:
-    static std::map<uint16_t, uint16_t> bindingIdToImageArrayElementId;
-
     struct Details {
-        static uint32_t imageId;
-        uint32_t bindingId;
         const char* filePath;
         uint16_t width;
         uint16_t height;
@@ -49,8 +45,7 @@ public:
             int stageUsage, VkImageTiling tiling,
             int aspectFlags,
             VkSampleCountFlagBits samples,
-            stbi_uc* pixels = nullptr,
-            uint32_t bindingId = imageId++);
+            stbi_uc* pixels = nullptr);
     } imageDetails;
 
     void create(VkDevice& device, VkPhysicalDevice& physicalDevice,
@@ -60,6 +55,9 @@ public:
                            VkImageLayout dstLayout);
     void copyBufferToImage(Queue& queue, unsigned char* buffer);
     void copyBufferToImage(Queue& queue, unsigned char* buffer, uint32_t bufImageWidth, uint32_t bufImageHeight);
+    void copyBufferRegionToImage(Queue& queue, const unsigned char* buffer, VkOffset2D offset, VkExtent2D extent);
+    // Rows of the region are written one after another, image must be created with transfer source usage.
+    void copyImageRegionToBuffer(Queue& queue, VkOffset2D offset, VkExtent2D extent, std::vector<unsigned char>& regionTexels);
     void createImageView();
     void destroy();
     const VkImage& get() const;
@@ -1,27 +1,64 @@
 #include "pipeline.h"
 
-void Pipeline::create(VkDevice& device, VkRenderPass& renderPass,
+// Deleter of shared pipeline set, called when neither history nor frames in flight reference it.
+static void destroyPipelineSet(VkDevice device, PipelineSet* pipelineSet)
+{
+    vkDestroyPipeline(device, pipelineSet->graphics, nullptr);
+    vkDestroyPipelineLayout(device, pipelineSet->graphicsLayout, nullptr);
+    vkDestroyPipeline(device, pipelineSet->upscale, nullptr);
+    vkDestroyPipelineLayout(device, pipelineSet->upscaleLayout, nullptr);
+    for (size_t i = 0; i < pipelineSet->computes.size(); i++) {
+        vkDestroyPipeline(device, pipelineSet->computes[i], nullptr);
+        vkDestroyPipelineLayout(device, pipelineSet->computeLayouts[i], nullptr);
+    }
+    delete pipelineSet;
+}
+
+void Pipeline::create(VkDevice& device, VkPipelineCache& pipelineCache,
+    VkRenderPass& renderPass, VkRenderPass& presentRenderPass,
     std::vector<VkDescriptorSetLayout>& descriptorSetLayouts,
     const VkExtent2D extent, VkSampleCountFlagBits samples)
 {
+    // Shader modules and context are shared with the background build, so it must finish first.
+    waitForPendingBuild();
+
     this->device = device;
+    this->pipelineCache = pipelineCache;
     this->renderPass = renderPass;
+    this->presentRenderPass = presentRenderPass;
     this->descriptorSetLayouts = descriptorSetLayouts;
     this->extent = extent;
     this->samples = samples;
+    framePipelineSets.resize(MAX_FRAMES_IN_FLIGHT);
+
+    PipelineSet pipelineSet = build(renderPass, extent, samples);
+    pipelineSet.shadersVersion = shadersVersion;
+    publish(pipelineSet);
+}
+
+/* Compiles shaders and builds pipelines without touching pipeline history, so it can run on a worker
+   thread while the render thread draws with previous pipelines. Pipeline cache is internally
+   synchronized, so it is shared with pipelines created on the render thread. */
+PipelineSet Pipeline::build(VkRenderPass renderPass, const VkExtent2D extent, VkSampleCountFlagBits samples)
+{
+    PipelineSet pipelineSet {};
+    pipelineSet.samples = samples;
 
     try {
-        shaderManager.createShaderModules(device);
-    } catch (std::format_error err) {
+        shaderManager.createShaderModules(device, shadersChanged);
+    } catch (const std::exception&) {
         std::cout << "[Graphics Pipeline] Fail graphics pipeline creation due to "
                      "failed shader compilation."
                   << '\n';
-        return;
+        shaderManager.destroyShaderModules();
+        return pipelineSet;
     }
 
     std::vector<VkPipelineShaderStageCreateInfo> shaderModules {};
+    std::vector<VkPipelineShaderStageCreateInfo> upscaleShaderModules {};
     std::vector<VkPipelineShaderStageCreateInfo> computeShaderModules {};
-    for (const std::pair<VkShaderStageFlagBits, VkShaderModule_T*>& shaderModule : shaderManager.getShaderModules()) {
+    std::vector<std::string> computeShaderNames {};
+    for (const auto& [shaderName, shaderModule] : shaderManager.getShaderModules()) {
         if (shaderModule.first == VK_SHADER_STAGE_COMPUTE_BIT) {
             VkPipelineShaderStageCreateInfo computeShaderModuleInfo {};
             computeShaderModuleInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
@@ -30,6 +67,7 @@ void Pipeline::create(VkDevice& device, VkRenderPass& renderPass,
             computeShaderModuleInfo.pName = "main";
             computeShaderModuleInfo.pSpecializationInfo = nullptr;
             computeShaderModules.push_back(computeShaderModuleInfo);
+            computeShaderNames.push_back(shaderName);
         } else {
             VkPipelineShaderStageCreateInfo shaderModuleInfo {};
             shaderModuleInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
@@ -37,7 +75,12 @@ void Pipeline::create(VkDevice& device, VkRenderPass& renderPass,
             shaderModuleInfo.module = shaderModule.second;
             shaderModuleInfo.pName = "main";
             shaderModuleInfo.pSpecializationInfo = nullptr;
-            shaderModules.push_back(shaderModuleInfo);
+            const std::string pipelineName = shaderName.substr(0, shaderName.find('.'));
+            if (pipelineName == PAINTING_SHADER_NAME) {
+                shaderModules.push_back(shaderModuleInfo);
+            } else if (pipelineName == UPSCALE_SHADER_NAME) {
+                upscaleShaderModules.push_back(shaderModuleInfo);
+            }
         }
     }
 
@@ -142,7 +185,7 @@ void Pipeline::create(VkDevice& device, VkRenderPass& renderPass,
     if (vkCreatePipelineLayout(device, &pipelineLayoutInfo, nullptr, &layout) != VK_SUCCESS) {
         throw std::runtime_error("Failed to create pipeline layout.");
     }
-    graphicsPipelineLayouts.push_back(layout);
+    pipelineSet.graphicsLayout = layout;
 
     VkGraphicsPipelineCreateInfo graphicsPipelineInfo {};
     graphicsPipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
@@ -163,10 +206,12 @@ void Pipeline::create(VkDevice& device, VkRenderPass& renderPass,
     graphicsPipelineInfo.basePipelineIndex = -1;
 
     VkPipeline graphicsPipeline;
-    if (vkCreateGraphicsPipelines(device, VK_NULL_HANDLE, 1, &graphicsPipelineInfo, nullptr, &graphicsPipeline) != VK_SUCCESS) {
+    if (vkCreateGraphicsPipelines(device, pipelineCache, 1, &graphicsPipelineInfo, nullptr, &graphicsPipeline) != VK_SUCCESS) {
         throw std::runtime_error("Failed to create graphics pipeline.");
     }
-    graphicsPipelines.push_back(graphicsPipeline);
+    pipelineSet.graphics = graphicsPipeline;
+
+    createUpscalePipeline(upscaleShaderModules, pipelineSet);
 
     // Compute Pipeline Creation
     for (size_t i = 0; i < computeShaderModules.size(); i++) {
@@ -180,56 +225,250 @@ void Pipeline::create(VkDevice& device, VkRenderPass& renderPass,
         if (vkCreatePipelineLayout(device, &computePipelineLayoutInfo, nullptr, &computePipelineLayout) != VK_SUCCESS) {
             throw std::runtime_error("Failed to create compute pipeline layout.");
         }
-        computePipelineLayouts.push_back(computePipelineLayout);
+        pipelineSet.computeLayouts.push_back(computePipelineLayout);
 
         VkComputePipelineCreateInfo computePipelineInfo {};
         computePipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
-        computePipelineInfo.layout = computePipelineLayouts[i];
+        computePipelineInfo.layout = computePipelineLayout;
         computePipelineInfo.stage = computeShaderModules[i];
 
         VkPipeline computePipeline;
-        if (vkCreateComputePipelines(device, VK_NULL_HANDLE, 1,
+        if (vkCreateComputePipelines(device, pipelineCache, 1,
                 &computePipelineInfo, nullptr, &computePipeline)
             != VK_SUCCESS) {
             throw std::runtime_error("Failed to create compute pipeline.");
         }
 
-        computePipelines.push_back(computePipeline);
+        pipelineSet.computes.push_back(computePipeline);
     }
+    pipelineSet.computeShaderNames = computeShaderNames;
+    pipelineSet.built = true;
 
     shaderManager.destroyShaderModules();
+    return pipelineSet;
 }
 
-void Pipeline::destroy()
+// Appends built pipelines to history and evicts the oldest set when history is full, called only on the render thread.
+void Pipeline::publish(PipelineSet& pipelineSet)
+{
+    if (!pipelineSet.built) {
+        return;
+    }
+
+    pipelineSet.id = publishedSetsCount++;
+    const VkDevice device = this->device;
+    pipelineHistory.push_back(std::shared_ptr<PipelineSet>(new PipelineSet(pipelineSet),
+        [device](PipelineSet* retiredSet) { destroyPipelineSet(device, retiredSet); }));
+    if (pipelineHistory.size() > MAX_PIPELINE_HISTORY_SIZE) {
+        pipelineHistory.pop_front();
+    }
+}
+
+// Background build is started only when shader files are changed, so its set has the next shaders version.
+void Pipeline::publishPendingBuild(PipelineSet& pipelineSet)
+{
+    if (pipelineSet.built) {
+        pipelineSet.shadersVersion = ++shadersVersion;
+    }
+    publish(pipelineSet);
+}
+
+void Pipeline::waitForPendingBuild()
 {
-    for (size_t i = 0; i < graphicsPipelineLayouts.size(); i++) {
-        vkDestroyPipeline(device, graphicsPipelines[i], nullptr);
-        vkDestroyPipelineLayout(device, graphicsPipelineLayouts[i], nullptr);
-        vkDestroyPipeline(device, computePipelines[i], nullptr);
-        vkDestroyPipelineLayout(device, computePipelineLayouts[i], nullptr);
+    if (pendingBuild.valid()) {
+        PipelineSet pipelineSet = pendingBuild.get();
+        publishPendingBuild(pipelineSet);
+    }
+}
+
+/* Pipeline of the present pass that draws fullscreen triangle, which samples painting rendered at
+   render scale and upscales it to the swapchain extent. Triangle vertices are generated in the
+   vertex shader, so there is no vertex input, and present pass has no depth attachment. */
+void Pipeline::createUpscalePipeline(std::vector<VkPipelineShaderStageCreateInfo>& shaderStages, PipelineSet& pipelineSet)
+{
+    const std::vector<VkDynamicState> dynamicStates = { VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR };
+    VkPipelineDynamicStateCreateInfo dynamicStateInfo {};
+    dynamicStateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+    dynamicStateInfo.dynamicStateCount = static_cast<uint32_t>(dynamicStates.size());
+    dynamicStateInfo.pDynamicStates = dynamicStates.data();
+
+    VkPipelineViewportStateCreateInfo viewportInfo {};
+    viewportInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+    viewportInfo.viewportCount = 1;
+    viewportInfo.scissorCount = 1;
+
+    VkPipelineColorBlendAttachmentState colorBlendAttachment {};
+    colorBlendAttachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+    colorBlendAttachment.blendEnable = VK_FALSE;
+
+    VkPipelineColorBlendStateCreateInfo colorBlending {};
+    colorBlending.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+    colorBlending.logicOpEnable = VK_FALSE;
+    colorBlending.attachmentCount = 1;
+    colorBlending.pAttachments = &colorBlendAttachment;
+
+    VkPipelineVertexInputStateCreateInfo vertexInfo {};
+    vertexInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+
+    VkPipelineInputAssemblyStateCreateInfo inputAssembly {};
+    inputAssembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+    inputAssembly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+    inputAssembly.primitiveRestartEnable = VK_FALSE;
+
+    VkPipelineRasterizationStateCreateInfo rasterizer {};
+    rasterizer.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+    rasterizer.polygonMode = VK_POLYGON_MODE_FILL;
+    rasterizer.lineWidth = 1.0f;
+    rasterizer.cullMode = VK_CULL_MODE_NONE;
+    rasterizer.frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
+
+    VkPipelineMultisampleStateCreateInfo multisampling {};
+    multisampling.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+    multisampling.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+    multisampling.sampleShadingEnable = VK_FALSE;
+
+    VkPushConstantRange pushConstantRange {};
+    pushConstantRange.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+    pushConstantRange.offset = 0;
+    pushConstantRange.size = sizeof(UpscalePushConstants);
+
+    VkPipelineLayoutCreateInfo pipelineLayoutInfo {};
+    pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    pipelineLayoutInfo.setLayoutCount = static_cast<uint32_t>(descriptorSetLayouts.size());
+    pipelineLayoutInfo.pSetLayouts = descriptorSetLayouts.data();
+    pipelineLayoutInfo.pushConstantRangeCount = 1;
+    pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+
+    VkPipelineLayout layout;
+    if (vkCreatePipelineLayout(device, &pipelineLayoutInfo, nullptr, &layout) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to create upscale pipeline layout.");
+    }
+    pipelineSet.upscaleLayout = layout;
+
+    VkGraphicsPipelineCreateInfo upscalePipelineInfo {};
+    upscalePipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+    upscalePipelineInfo.stageCount = static_cast<uint32_t>(shaderStages.size());
+    upscalePipelineInfo.pStages = shaderStages.data();
+    upscalePipelineInfo.pViewportState = &viewportInfo;
+    upscalePipelineInfo.pDynamicState = &dynamicStateInfo;
+    upscalePipelineInfo.pColorBlendState = &colorBlending;
+    upscalePipelineInfo.pDepthStencilState = nullptr;
+    upscalePipelineInfo.pVertexInputState = &vertexInfo;
+    upscalePipelineInfo.pInputAssemblyState = &inputAssembly;
+    upscalePipelineInfo.pRasterizationState = &rasterizer;
+    upscalePipelineInfo.pMultisampleState = &multisampling;
+    upscalePipelineInfo.layout = layout;
+    upscalePipelineInfo.renderPass = presentRenderPass;
+    upscalePipelineInfo.subpass = 0;
+    upscalePipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
+    upscalePipelineInfo.basePipelineIndex = -1;
+
+    VkPipeline upscalePipeline;
+    if (vkCreateGraphicsPipelines(device, pipelineCache, 1, &upscalePipelineInfo, nullptr, &upscalePipeline) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to create upscale pipeline.");
     }
+    pipelineSet.upscale = upscalePipeline;
+}
+
+// Device must be idle, so sets referenced by frames can be destroyed too.
+void Pipeline::destroy()
+{
+    waitForPendingBuild();
+    framePipelineSets.clear();
+    pipelineHistory.clear();
 }
 
+/* Starts background build when shader files are changed and returns true once built pipelines are
+   added to history. Previous pipelines keep drawing until then. Flag is cleared before the build
+   starts, so changes made during the build start another one. */
 bool Pipeline::recreateifShadersChanged()
 {
-    if (ShaderManager::recreateGraphicsPipeline) {
-        Pipeline::create(device, renderPass, descriptorSetLayouts, extent,
-            samples);
-        ShaderManager::recreateGraphicsPipeline = false;
-        return true;
+    if (pendingBuild.valid()) {
+        if (pendingBuild.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+            return false;
+        }
+        PipelineSet pipelineSet = pendingBuild.get();
+        publishPendingBuild(pipelineSet);
+        return pipelineSet.built;
+    }
+
+    if (ShaderManager::recreateGraphicsPipeline.exchange(false)) {
+        shadersChanged = true;
+        pendingBuild = std::async(std::launch::async, &Pipeline::build, this, renderPass, extent, samples);
     }
 
     return false;
 }
 
-void Pipeline::bind(VkCommandBuffer& cmdCompute, VkDescriptorSet& descriptorSet, VkDescriptorSet& bindlessDescriptorSet)
+/* Called before render pass is destroyed. Background build creates pipelines with the current render pass,
+   so it is finished first. Device must be idle, so sets referenced only by completed frames are released. */
+void Pipeline::releaseRenderPass()
+{
+    waitForPendingBuild();
+    for (std::vector<std::shared_ptr<PipelineSet>>& pipelineSets : framePipelineSets) {
+        pipelineSets.clear();
+    }
+    renderPass = VK_NULL_HANDLE;
+}
+
+/* Render pass with the new sample count is incompatible with pipelines of another sample count. Set that was
+   built for this sample count from the current shaders is moved to the end of history, so quality changes do
+   not fill history with copies, otherwise new set is built. Render pass of the same sample count is compatible
+   with the set, so it is kept. */
+void Pipeline::changeSampleCount(VkRenderPass& renderPass, VkSampleCountFlagBits samples)
+{
+    const auto pipelineSetIt = std::find_if(pipelineHistory.rbegin(), pipelineHistory.rend(),
+        [this, samples](const std::shared_ptr<PipelineSet>& pipelineSet) {
+            return pipelineSet->samples == samples && pipelineSet->shadersVersion == shadersVersion;
+        });
+    if (pipelineSetIt == pipelineHistory.rend()) {
+        Pipeline::create(device, pipelineCache, renderPass, presentRenderPass, descriptorSetLayouts, extent,
+            samples);
+        return;
+    }
+
+    std::shared_ptr<PipelineSet> pipelineSet = *pipelineSetIt;
+    pipelineHistory.erase(std::next(pipelineSetIt).base());
+    pipelineHistory.push_back(pipelineSet);
+    this->renderPass = renderPass;
+    this->samples = samples;
+}
+
+bool Pipeline::isCompatible(const size_t index) const
+{
+    return pipelineHistory[index]->samples == samples;
+}
+
+// Keeps selected set and the latest set, which upscale and compute pipelines are taken from, alive until frame is completed.
+void Pipeline::retainForFrame(const size_t index, uint32_t currentFrame)
 {
-    const uint32_t dynamicOffset = static_cast<uint32_t>(Data::AlignmentProperties::dynamicUniformAlignment_mat4);
-    VkPipelineLayout layout =  computePipelineLayouts.back();
-    VkPipeline pipeline = computePipelines.back();
+    framePipelineSets[currentFrame].push_back(pipelineHistory[index]);
+    framePipelineSets[currentFrame].push_back(pipelineHistory.back());
+}
+
+// Called after fence of the frame is signaled.
+void Pipeline::releaseFrame(uint32_t currentFrame)
+{
+    framePipelineSets[currentFrame].clear();
+}
+
+// Compute pipelines are taken from the latest set.
+void Pipeline::bind(VkCommandBuffer& cmdCompute, VkDescriptorSet& descriptorSet, VkDescriptorSet& bindlessDescriptorSet,
+    const std::string& computeShaderName, uint32_t currentFrame)
+{
+    const std::shared_ptr<PipelineSet>& pipelineSet = pipelineHistory.back();
+    const auto computeShaderNameIt = std::find(pipelineSet->computeShaderNames.begin(),
+        pipelineSet->computeShaderNames.end(), computeShaderName);
+    if (computeShaderNameIt == pipelineSet->computeShaderNames.end()) {
+        throw std::runtime_error("Compute pipeline is not created for shader " + computeShaderName);
+    }
+    const size_t computePipelineIndex = std::distance(pipelineSet->computeShaderNames.begin(), computeShaderNameIt);
+    VkPipelineLayout layout = pipelineSet->computeLayouts[computePipelineIndex];
+    VkPipeline pipeline = pipelineSet->computes[computePipelineIndex];
+    framePipelineSets[currentFrame].push_back(pipelineSet);
     vkCmdBindDescriptorSets(cmdCompute, VK_PIPELINE_BIND_POINT_COMPUTE,
          layout, 0, 1,
-         &descriptorSet, 1, &dynamicOffset);
+         &descriptorSet, 0, nullptr);
     vkCmdBindDescriptorSets(cmdCompute, VK_PIPELINE_BIND_POINT_COMPUTE,
          layout, 1, 1,
          &bindlessDescriptorSet, 0, nullptr);
@@ -241,24 +480,49 @@ void Pipeline::updateExtent(VkExtent2D& extent)
     this->extent = extent;
 }
 
-VkPipelineLayout& Pipeline::getLastLayout()
+VkPipelineLayout& Pipeline::getLayout(const size_t index)
 {
-    return graphicsPipelineLayouts[graphicsPipelineLayouts.size() - 1];
+    return pipelineHistory[index]->graphicsLayout;
 }
 
-VkPipeline& Pipeline::getLast()
+VkPipeline& Pipeline::get(const size_t index)
 {
-    return graphicsPipelines[graphicsPipelineLayouts.size() - 1];
+    return pipelineHistory[index]->graphics;
 }
 
-VkPipelineLayout& Pipeline::getLayout(const size_t index)
+VkPipelineLayout& Pipeline::getUpscaleLayout()
 {
-    return graphicsPipelineLayouts[index];
+    return pipelineHistory.back()->upscaleLayout;
 }
 
-VkPipeline& Pipeline::get(const size_t index)
+VkPipeline& Pipeline::getUpscale()
+{
+    return pipelineHistory.back()->upscale;
+}
+
+size_t Pipeline::getPipelineHistorySize() { return pipelineHistory.size(); }
+
+uint32_t Pipeline::getPipelineId(const size_t index) const
 {
-    return graphicsPipelines[index];
+    return pipelineHistory[index]->id;
 }
 
-size_t Pipeline::getPipelineHistorySize() { return graphicsPipelines.size(); }
+std::vector<uint32_t> Pipeline::getPipelineIds() const
+{
+    std::vector<uint32_t> pipelineIds;
+    pipelineIds.reserve(pipelineHistory.size());
+    for (const std::shared_ptr<PipelineSet>& pipelineSet : pipelineHistory) {
+        pipelineIds.push_back(pipelineSet->id);
+    }
+    return pipelineIds;
+}
+
+std::optional<size_t> Pipeline::findPipelineIndex(const uint32_t id) const
+{
+    const auto pipelineSetIt = std::find_if(pipelineHistory.begin(), pipelineHistory.end(),
+        [id](const std::shared_ptr<PipelineSet>& pipelineSet) { return pipelineSet->id == id; });
+    if (pipelineSetIt == pipelineHistory.end()) {
+        return std::nullopt;
+    }
+    return static_cast<size_t>(std::distance(pipelineHistory.begin(), pipelineSetIt));
+}
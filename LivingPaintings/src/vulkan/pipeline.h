@@ -1,33 +1,91 @@
 #pragma once
 #include "shader_manager.h"
 #include "vertex_data.h"
+#include <algorithm>
+#include <chrono>
+#include <deque>
+#include <future>
+#include <map>
+#include <memory>
+#include <optional>
+#include <string>
 #include <vector>
 #include <vulkan/vulkan.h>
 
+using Constants::PAINTING_SHADER_NAME;
+using Constants::UPSCALE_SHADER_NAME;
+using Constants::MAX_FRAMES_IN_FLIGHT;
+using Constants::MAX_PIPELINE_HISTORY_SIZE;
+
+// Push constants of the upscale pass, layout matches upscale.frag.
+struct UpscalePushConstants {
+    glm::vec2 uvScale; // part of the scene image that painting was rendered to
+    glm::vec2 texelSize;
+    float sharpness;
+};
+
+// Pipelines built from one set of shader files, added to history together.
+struct PipelineSet {
+    VkPipelineLayout graphicsLayout = VK_NULL_HANDLE;
+    VkPipeline graphics = VK_NULL_HANDLE;
+    VkSampleCountFlagBits samples = VK_SAMPLE_COUNT_1_BIT;
+    VkPipelineLayout upscaleLayout = VK_NULL_HANDLE;
+    VkPipeline upscale = VK_NULL_HANDLE;
+    std::vector<VkPipelineLayout> computeLayouts;
+    std::vector<VkPipeline> computes;
+    std::vector<std::string> computeShaderNames;
+    bool built = false; // false when shader compilation failed
+    uint32_t id = 0; // number of the set in order of publishing, shown in pipeline history
+    uint32_t shadersVersion = 0; // sets that are built from the same shader files share the version
+};
+
 class Pipeline {
 
     ShaderManager shaderManager;
-    std::vector<VkPipelineLayout> graphicsPipelineLayouts;
-    std::vector<VkPipeline> graphicsPipelines;
-    std::vector<VkPipelineLayout> computePipelineLayouts;
-    std::vector<VkPipeline> computePipelines;
+    /* Sets are shared by history and by frames that recorded commands with them. Set that is evicted
+       from history is destroyed once the last frame that used it is completed. */
+    std::deque<std::shared_ptr<PipelineSet>> pipelineHistory; // oldest first
+    std::vector<std::vector<std::shared_ptr<PipelineSet>>> framePipelineSets;
+    uint32_t publishedSetsCount = 0;
+    uint32_t shadersVersion = 0; // version of the latest built shader files
     VkDevice device = VK_NULL_HANDLE;
+    VkPipelineCache pipelineCache = VK_NULL_HANDLE;
     VkRenderPass renderPass = VK_NULL_HANDLE;
+    VkRenderPass presentRenderPass = VK_NULL_HANDLE;
     std::vector<VkDescriptorSetLayout> descriptorSetLayouts;
     VkExtent2D extent;
     VkSampleCountFlagBits samples;
+    std::future<PipelineSet> pendingBuild; // shader reload that is built on a worker thread
+    bool shadersChanged = false; // embedded shaders are outdated once shader files are changed
+
+    PipelineSet build(VkRenderPass renderPass, const VkExtent2D extent, VkSampleCountFlagBits samples);
+    void createUpscalePipeline(std::vector<VkPipelineShaderStageCreateInfo>& shaderStages, PipelineSet& pipelineSet);
+    void publish(PipelineSet& pipelineSet);
+    void publishPendingBuild(PipelineSet& pipelineSet);
+    void waitForPendingBuild();
 
 public:
-    void create(VkDevice& device, VkRenderPass& renderPass,
+    void create(VkDevice& device, VkPipelineCache& pipelineCache,
+        VkRenderPass& renderPass, VkRenderPass& presentRenderPass,
         std::vector<VkDescriptorSetLayout>& descriptorSetLayouts,
         const VkExtent2D extent, VkSampleCountFlagBits samples);
     void destroy();
     bool recreateifShadersChanged();
-    void bind(VkCommandBuffer& cmdCompute, VkDescriptorSet& descriptorSet, VkDescriptorSet& bindlessDescriptorSet);
+    void releaseRenderPass();
+    void changeSampleCount(VkRenderPass& renderPass, VkSampleCountFlagBits samples);
+    bool isCompatible(const size_t index) const;
+    void retainForFrame(const size_t index, uint32_t currentFrame);
+    void releaseFrame(uint32_t currentFrame);
+    void bind(VkCommandBuffer& cmdCompute, VkDescriptorSet& descriptorSet, VkDescriptorSet& bindlessDescriptorSet,
+        const std::string& computeShaderName, uint32_t currentFrame);
     void updateExtent(VkExtent2D& extent);
-    VkPipelineLayout& getLastLayout();
-    VkPipeline& getLast();
     VkPipelineLayout& getLayout(const size_t index);
     VkPipeline& get(const size_t index);
+    VkPipelineLayout& getUpscaleLayout();
+    VkPipeline& getUpscale();
     size_t getPipelineHistorySize();
+    uint32_t getPipelineId(const size_t index) const;
+    std::vector<uint32_t> getPipelineIds() const;
+    // Returns nothing when set with the id was evicted from history.
+    std::optional<size_t> findPipelineIndex(const uint32_t id) const;
 };
@@ -0,0 +1,103 @@
+#include "pipeline_cache.h"
+
+VkPipelineCache& PipelineCache::create(Device& device, const std::filesystem::path& filePath)
+{
+    this->device = device.get();
+    this->filePath = filePath;
+
+    const VkPhysicalDeviceProperties properties = device.getProperties();
+    deviceHeader.vendorID = properties.vendorID;
+    deviceHeader.deviceID = properties.deviceID;
+    deviceHeader.driverVersion = properties.driverVersion;
+    std::memcpy(deviceHeader.pipelineCacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE);
+
+    const std::vector<char> cacheData = readCacheData();
+
+    VkPipelineCacheCreateInfo pipelineCacheInfo {};
+    pipelineCacheInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+    pipelineCacheInfo.initialDataSize = cacheData.size();
+    pipelineCacheInfo.pInitialData = cacheData.empty() ? nullptr : cacheData.data();
+
+    if (vkCreatePipelineCache(this->device, &pipelineCacheInfo, nullptr, &pipelineCache) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to create pipeline cache.");
+    }
+    return pipelineCache;
+}
+
+// Returns empty data when file is missing, truncated, corrupted or was written by another device or driver.
+std::vector<char> PipelineCache::readCacheData() const
+{
+    std::ifstream file(filePath, std::ios::binary);
+    if (!file.is_open()) {
+        return {};
+    }
+
+    FileHeader fileHeader {};
+    file.read(reinterpret_cast<char*>(&fileHeader), sizeof(FileHeader));
+    if (!file || fileHeader.vendorID != deviceHeader.vendorID
+        || fileHeader.deviceID != deviceHeader.deviceID
+        || fileHeader.driverVersion != deviceHeader.driverVersion
+        || std::memcmp(fileHeader.pipelineCacheUUID, deviceHeader.pipelineCacheUUID, VK_UUID_SIZE) != 0) {
+        std::cout << "[Pipeline Cache] Cache file is outdated, pipelines will be rebuilt." << '\n';
+        return {};
+    }
+
+    // Size in the header is checked against the file, so corrupted header does not allocate arbitrary memory.
+    std::error_code error;
+    const std::uintmax_t fileSize = std::filesystem::file_size(filePath, error);
+    if (error || fileSize < sizeof(FileHeader) || fileHeader.dataSize != fileSize - sizeof(FileHeader)) {
+        std::cout << "[Pipeline Cache] Cache file is corrupted, pipelines will be rebuilt." << '\n';
+        return {};
+    }
+
+    std::vector<char> cacheData(fileHeader.dataSize);
+    file.read(cacheData.data(), cacheData.size());
+    if (!file) {
+        return {};
+    }
+    return cacheData;
+}
+
+// Data is written to temporary file first, so interrupted save does not leave broken cache.
+void PipelineCache::save()
+{
+    size_t dataSize = 0;
+    if (vkGetPipelineCacheData(device, pipelineCache, &dataSize, nullptr) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to get pipeline cache size.");
+    }
+    std::vector<char> cacheData(dataSize);
+    if (vkGetPipelineCacheData(device, pipelineCache, &dataSize, cacheData.data()) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to get pipeline cache data.");
+    }
+
+    FileHeader fileHeader = deviceHeader;
+    fileHeader.dataSize = dataSize;
+
+    std::filesystem::path tempFilePath = filePath;
+    tempFilePath += ".tmp";
+    {
+        std::ofstream file(tempFilePath, std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) {
+            std::cout << "[Pipeline Cache] Failed to open " << tempFilePath << " for writing." << '\n';
+            return;
+        }
+        file.write(reinterpret_cast<const char*>(&fileHeader), sizeof(FileHeader));
+        file.write(cacheData.data(), dataSize);
+    }
+
+    std::error_code error;
+    std::filesystem::rename(tempFilePath, filePath, error);
+    if (error) {
+        std::cout << "[Pipeline Cache] Failed to save cache: " << error.message() << '\n';
+    }
+}
+
+void PipelineCache::destroy()
+{
+    vkDestroyPipelineCache(device, pipelineCache, nullptr);
+}
+
+VkPipelineCache& PipelineCache::get()
+{
+    return pipelineCache;
+}
@@ -0,0 +1,37 @@
+#pragma once
+#include "consts.h"
+#include "device.h"
+#include "vulkan/vulkan.h"
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+
+/* Pipeline cache that is shared by all pipeline creation and persisted between runs. Cache data is
+   written after a header that identifies device and driver, so data of another device or driver
+   version is discarded and cache starts empty. */
+class PipelineCache {
+
+    struct FileHeader {
+        uint32_t vendorID;
+        uint32_t deviceID;
+        uint32_t driverVersion;
+        uint8_t pipelineCacheUUID[VK_UUID_SIZE];
+        uint64_t dataSize;
+    };
+
+    VkPipelineCache pipelineCache = VK_NULL_HANDLE;
+    VkDevice device = VK_NULL_HANDLE;
+    FileHeader deviceHeader {};
+    std::filesystem::path filePath;
+
+    std::vector<char> readCacheData() const;
+
+public:
+    VkPipelineCache& create(Device& device, const std::filesystem::path& filePath);
+    void save();
+    void destroy();
+    VkPipelineCache& get();
+};
@@ -0,0 +1,122 @@
+#include "quality_governor.h"
+
+void QualityGovernor::create(Device& device, VkSampleCountFlagBits maxSampleCount)
+{
+    this->device = device.get();
+    this->maxSampleCount = maxSampleCount;
+
+    const VkPhysicalDeviceLimits limits = device.getProperties().limits;
+    timestampsSupported = limits.timestampComputeAndGraphics == VK_TRUE;
+    timestampPeriod_ns = limits.timestampPeriod;
+    queriesWritten.assign(MAX_FRAMES_IN_FLIGHT, false);
+    if (!timestampsSupported) {
+        std::cout << "[Quality Governor] Device does not support timestamps, quality is not adapted." << '\n';
+        return;
+    }
+
+    VkQueryPoolCreateInfo queryPoolInfo {};
+    queryPoolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+    queryPoolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+    queryPoolInfo.queryCount = 2 * MAX_FRAMES_IN_FLIGHT;
+
+    if (vkCreateQueryPool(this->device, &queryPoolInfo, nullptr, &queryPool) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to create timestamp query pool.");
+    }
+}
+
+void QualityGovernor::destroy()
+{
+    vkDestroyQueryPool(device, queryPool, nullptr);
+}
+
+void QualityGovernor::writeBeginTimestamp(VkCommandBuffer& commandBuffer, uint32_t currentFrame)
+{
+    if (!timestampsSupported) {
+        return;
+    }
+
+    vkCmdResetQueryPool(commandBuffer, queryPool, 2 * currentFrame, 2);
+    vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, queryPool, 2 * currentFrame);
+}
+
+void QualityGovernor::writeEndTimestamp(VkCommandBuffer& commandBuffer, uint32_t currentFrame)
+{
+    if (!timestampsSupported) {
+        return;
+    }
+
+    vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, queryPool, 2 * currentFrame + 1);
+    queriesWritten[currentFrame] = true;
+}
+
+// Must be called after the fence of the frame is signaled, results are not waited for.
+void QualityGovernor::collectFrameTime(uint32_t currentFrame)
+{
+    if (!timestampsSupported || !queriesWritten[currentFrame]) {
+        return;
+    }
+
+    std::array<uint64_t, 2> timestamps {};
+    VkResult result = vkGetQueryPoolResults(device, queryPool, 2 * currentFrame, 2,
+        sizeof(timestamps), timestamps.data(), sizeof(uint64_t), VK_QUERY_RESULT_64_BIT);
+    if (result != VK_SUCCESS) {
+        return;
+    }
+    queriesWritten[currentFrame] = false;
+
+    frameTime_ms = static_cast<float>(timestamps[1] - timestamps[0]) * timestampPeriod_ns / 1000000.0f;
+    sampledFrameTime_ms += frameTime_ms;
+    sampledFrames++;
+}
+
+void QualityGovernor::update(QualityParams& qualityParams, bool exporting)
+{
+    qualityParams.gpuFrameTime_ms = frameTime_ms;
+    qualityParams.qualityLevel = static_cast<int>(level);
+
+    // Export frames are not presented in real time, so their time is not sampled.
+    if (!qualityParams.autoQuality || exporting) {
+        sampledFrameTime_ms = 0.0f;
+        sampledFrames = 0;
+        return;
+    }
+    if (sampledFrames < QUALITY_SAMPLE_FRAMES) {
+        return;
+    }
+
+    const float averageFrameTime_ms = sampledFrameTime_ms / sampledFrames;
+    sampledFrameTime_ms = 0.0f;
+    sampledFrames = 0;
+
+    int levelChange = 0;
+    if (averageFrameTime_ms > qualityParams.frameBudget_ms && level > 0) {
+        levelChange = -1;
+    } else if (averageFrameTime_ms < qualityParams.frameBudget_ms * QUALITY_RAISE_THRESHOLD
+        && level < qualityLevels.size() - 1) {
+        levelChange = 1;
+    }
+
+    if (levelChange != 0 && getSampleCount(level + levelChange) != getSampleCount(level)) {
+        pendingLevelChangeWindows = levelChange == pendingLevelChange ? pendingLevelChangeWindows + 1 : 1;
+        pendingLevelChange = levelChange;
+        if (pendingLevelChangeWindows < SAMPLE_COUNT_CHANGE_WINDOWS) {
+            return;
+        }
+    }
+    pendingLevelChange = 0;
+    pendingLevelChangeWindows = 0;
+    level += levelChange;
+    qualityParams.qualityLevel = static_cast<int>(level);
+}
+
+QualityGovernor::QualityLevel QualityGovernor::getQualityLevel(bool exporting) const
+{
+    QualityLevel qualityLevel = exporting ? qualityLevels.back() : qualityLevels[level];
+    qualityLevel.samples = std::min(qualityLevel.samples, maxSampleCount);
+    return qualityLevel;
+}
+
+VkSampleCountFlagBits QualityGovernor::getSampleCount(size_t level) const
+{
+    return std::min(qualityLevels[level].samples, maxSampleCount);
+}
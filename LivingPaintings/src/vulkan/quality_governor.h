@@ -0,0 +1,67 @@
+#pragma once
+#include "consts.h"
+#include "device.h"
+#include "gui_params.h"
+#include "vulkan/vulkan.h"
+#include <algorithm>
+#include <array>
+#include <stdexcept>
+#include <vector>
+
+using Constants::MAX_FRAMES_IN_FLIGHT;
+using Constants::QUALITY_SAMPLE_FRAMES;
+using Constants::QUALITY_RAISE_THRESHOLD;
+using Constants::SAMPLE_COUNT_CHANGE_WINDOWS;
+
+/* Adapts rendering quality to keep GPU time of a frame within the frame budget. GPU time is measured
+   with timestamps written at the begin and the end of every graphics command buffer. Quality is
+   changed by one level after average time of sampled frames leaves the band between raise
+   threshold and the budget, so quality does not oscillate between neighbouring levels. Change of sample
+   count rebuilds render pass and pipelines, so level with another sample count is taken only after several
+   sampled windows in a row ask for it. */
+class QualityGovernor {
+
+public:
+    struct QualityLevel {
+        float renderScale;
+        float parallaxLayers;
+        VkSampleCountFlagBits samples;
+    };
+
+private:
+    /* Ordered from the cheapest level to the final quality that is used for export. Painting pass always
+       resolves multisampled color into the scene image, so the cheapest levels keep 2 samples. */
+    const std::array<QualityLevel, 6> qualityLevels = { {
+        { 0.5f, 8.0f, VK_SAMPLE_COUNT_2_BIT },
+        { 0.67f, 16.0f, VK_SAMPLE_COUNT_2_BIT },
+        { 0.75f, 24.0f, VK_SAMPLE_COUNT_2_BIT },
+        { 0.85f, 32.0f, VK_SAMPLE_COUNT_2_BIT },
+        { 1.0f, 40.0f, VK_SAMPLE_COUNT_4_BIT },
+        { 1.0f, 50.0f, VK_SAMPLE_COUNT_4_BIT }
+    } };
+
+    VkDevice device = VK_NULL_HANDLE;
+    VkQueryPool queryPool = VK_NULL_HANDLE;
+    VkSampleCountFlagBits maxSampleCount = VK_SAMPLE_COUNT_1_BIT;
+    bool timestampsSupported = false;
+    float timestampPeriod_ns = 1.0f;
+    std::vector<bool> queriesWritten; // begin and end timestamps of the frame wait to be collected
+    size_t level = qualityLevels.size() - 1;
+    float frameTime_ms = 0.0f;
+    float sampledFrameTime_ms = 0.0f;
+    uint32_t sampledFrames = 0;
+    int pendingLevelChange = 0; // -1 or 1 while change of sample count waits, 0 otherwise
+    uint32_t pendingLevelChangeWindows = 0;
+
+public:
+    void create(Device& device, VkSampleCountFlagBits maxSampleCount);
+    void destroy();
+    void writeBeginTimestamp(VkCommandBuffer& commandBuffer, uint32_t currentFrame);
+    void writeEndTimestamp(VkCommandBuffer& commandBuffer, uint32_t currentFrame);
+    void collectFrameTime(uint32_t currentFrame);
+    void update(QualityParams& qualityParams, bool exporting);
+    QualityLevel getQualityLevel(bool exporting) const;
+
+private:
+    VkSampleCountFlagBits getSampleCount(size_t level) const;
+};
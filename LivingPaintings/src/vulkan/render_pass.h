@@ -13,6 +13,7 @@ class RenderPass {
 public:
     VkRenderPass& create(VkDevice& device, VkFormat colorFormat,
         VkFormat depthFormat, VkSampleCountFlagBits samples);
+    VkRenderPass& createPresentPass(VkDevice& device, VkFormat colorFormat);
     void destroy();
     VkRenderPass& get();
     VkSampleCountFlagBits& getSampleCount();
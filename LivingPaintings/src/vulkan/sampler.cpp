@@ -1,6 +1,6 @@
 #include "sampler.h"
 
-void Sampler::create(VkDevice& device, VkPhysicalDevice& physicalDevice)
+void Sampler::create(VkDevice& device, VkPhysicalDevice& physicalDevice, VkFilter filter)
 {
     this->device = device;
 
@@ -9,12 +9,13 @@ void Sampler::create(VkDevice& device, VkPhysicalDevice& physicalDevice)
 
     VkSamplerCreateInfo samplerInfo {};
     samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
-    samplerInfo.magFilter = VK_FILTER_LINEAR;
-    samplerInfo.minFilter = VK_FILTER_LINEAR;
+    samplerInfo.magFilter = filter;
+    samplerInfo.minFilter = filter;
     samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT;
     samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT;
     samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT;
-    samplerInfo.anisotropyEnable = VK_TRUE;
+    // integer formats can't be filtered, so anisotropy is used only with linear filtering
+    samplerInfo.anisotropyEnable = filter == VK_FILTER_LINEAR ? VK_TRUE : VK_FALSE;
     samplerInfo.maxAnisotropy = properties.limits.maxSamplerAnisotropy;
     samplerInfo.borderColor = VK_BORDER_COLOR_INT_OPAQUE_BLACK;
     samplerInfo.unnormalizedCoordinates = VK_FALSE;
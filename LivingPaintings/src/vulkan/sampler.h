@@ -8,7 +8,7 @@ class Sampler {
     VkDevice device = VK_NULL_HANDLE;
 
 public:
-    void create(VkDevice& device, VkPhysicalDevice& physicalDevice);
+    void create(VkDevice& device, VkPhysicalDevice& physicalDevice, VkFilter filter = VK_FILTER_LINEAR);
     void destroy();
     VkSampler& get();
 };
@@ -2,6 +2,8 @@
 #include "../utils/path_params.hpp"
 
 using Runtime::PATH_PARAMS;
+using Constants::OUTPUT_FOLDER_NAME;
+using Constants::SHADER_CACHE_FOLDER_NAME;
 
 const std::map<std::string, shaderc_shader_kind> shaderTypes {
     { ".vert", shaderc_glsl_vertex_shader },
@@ -12,104 +14,194 @@ const std::map<std::string, shaderc_shader_kind> shaderTypes {
     { ".tese", shaderc_glsl_tess_evaluation_shader }
 };
 
-std::map<std::string, std::vector<char>> compiledShaders{};
+const shaderc_optimization_level optimizationLevel = shaderc_optimization_level_performance;
+const shaderc_env_version targetEnvironmentVersion = shaderc_env_version_vulkan_1_1;
+// Part of every cache key, so changed compile options invalidate all cached shaders.
+const std::string compileOptionsKey = std::to_string(optimizationLevel) + "/" + std::to_string(targetEnvironmentVersion);
+
+const std::regex includeDirective(R"(^\s*#\s*include\s*["<]([^">]+)[">])");
+const uint64_t fnvOffsetBasis = 14695981039346656037ull;
+const uint64_t fnvPrime = 1099511628211ull;
+
+std::map<std::string, std::vector<char>> compiledShaders {};
+std::map<uint64_t, std::vector<char>> cachedShaders {};
 
 void ShaderCompiler::compileIfChanged()
 {
-    const std::map<std::string, std::filesystem::directory_entry> shaderEntries = listModifiedFiles();
-    for (const auto shaderEntry : shaderEntries) {
-        std::filesystem::path shaderPath = shaderEntry.second.path();
-        std::string filename = shaderEntry.first + ".spv";
-        std::string spvPath = shaderPath.string() + ".spv";
-        std::vector<char> buffer = readShaderFile(shaderPath.string(), false);
-        compile(shaderPath, buffer.data());
-        std::cout << "Shader compiled: " + shaderPath.string();
-
-        const std::vector<char> compiledShader = readShaderFile(spvPath, true);
-        if (compiledShaders.contains(filename)) {
-            compiledShaders[filename] = compiledShader;
-        } else {
-            compiledShaders.insert({ filename, compiledShader });
+    const std::filesystem::path cachePath = std::filesystem::path(OUTPUT_FOLDER_NAME) / SHADER_CACHE_FOLDER_NAME;
+    std::filesystem::create_directories(cachePath);
+
+    std::map<std::string, uint64_t> shaderCacheKeys {};
+    std::map<uint64_t, std::future<std::vector<char>>> compilations {};
+    for (const std::filesystem::directory_entry& entry : std::filesystem::directory_iterator { PATH_PARAMS.SHADER_PATH }) {
+        const std::filesystem::path shaderPath = entry.path();
+        if (!entry.is_regular_file() || !shaderTypes.contains(shaderPath.extension().string())) {
+            continue;
+        }
+
+        const std::string shaderCode = readFile(shaderPath);
+        const uint64_t cacheKey = createCacheKey(shaderPath, shaderCode);
+        shaderCacheKeys.insert_or_assign(shaderPath.filename().string() + ".spv", cacheKey);
+        if (cachedShaders.contains(cacheKey) || compilations.contains(cacheKey)) {
+            continue;
+        }
+
+        const std::filesystem::path spvPath = cachePath / std::format("{:016x}.spv", cacheKey);
+        if (std::filesystem::exists(spvPath)) {
+            const std::string compiledShader = readFile(spvPath);
+            cachedShaders.insert({ cacheKey, std::vector<char>(compiledShader.begin(), compiledShader.end()) });
+            continue;
+        }
+
+        compilations.insert({ cacheKey, std::async(std::launch::async, &ShaderCompiler::compile, shaderPath, shaderCode) });
+    }
+
+    // All compilations are finished before the first error is rethrown.
+    std::exception_ptr compilationError;
+    for (auto& [cacheKey, compilation] : compilations) {
+        try {
+            std::vector<char> compiledShader = compilation.get();
+
+            // Written to temporary file first, so interrupted write does not leave broken cache entry.
+            const std::filesystem::path spvPath = cachePath / std::format("{:016x}.spv", cacheKey);
+            std::filesystem::path tempSpvPath = spvPath;
+            tempSpvPath += ".tmp";
+            {
+                std::ofstream shaderFile(tempSpvPath, std::ios::binary | std::ios::trunc);
+                shaderFile.write(compiledShader.data(), compiledShader.size());
+            }
+            std::error_code error;
+            std::filesystem::rename(tempSpvPath, spvPath, error);
+
+            cachedShaders.insert({ cacheKey, std::move(compiledShader) });
+        } catch (...) {
+            if (!compilationError) {
+                compilationError = std::current_exception();
+            }
         }
     }
+    if (compilationError) {
+        std::rethrow_exception(compilationError);
+    }
+
+    compiledShaders.clear();
+    std::set<uint64_t> usedCacheKeys {};
+    for (const auto& [filename, cacheKey] : shaderCacheKeys) {
+        compiledShaders.insert({ filename, cachedShaders.at(cacheKey) });
+        usedCacheKeys.insert(cacheKey);
+    }
+
+    // Only current versions of shaders are kept in memory, previous versions are loaded from the cache folder.
+    std::erase_if(cachedShaders, [&usedCacheKeys](const auto& cachedShader) {
+        return !usedCacheKeys.contains(cachedShader.first);
+    });
 }
 
-void ShaderCompiler::compile(std::filesystem::path shaderPath, const std::string& shaderCode)
+std::vector<char> ShaderCompiler::compile(std::filesystem::path shaderPath, const std::string& shaderCode)
 {
     shaderc::Compiler compiler;
     shaderc::CompileOptions options;
-    options.SetOptimizationLevel(shaderc_optimization_level_performance);
-    options.SetTargetEnvironment(shaderc_target_env_vulkan, shaderc_env_version_vulkan_1_1);
-    const char* filename = reinterpret_cast<const char*>(shaderPath.filename().c_str());
+    options.SetOptimizationLevel(optimizationLevel);
+    options.SetTargetEnvironment(shaderc_target_env_vulkan, targetEnvironmentVersion);
+    options.SetIncluder(std::make_unique<Includer>());
+    const std::string filename = shaderPath.filename().string();
     const std::string ext = shaderPath.extension().string();
-    std::string path = std::filesystem::absolute(shaderPath).string();
-    shaderc::SpvCompilationResult shaderModule = compiler.CompileGlslToSpv(shaderCode, shaderTypes.find(ext)->second, filename, options);
+    shaderc::SpvCompilationResult shaderModule = compiler.CompileGlslToSpv(shaderCode, shaderTypes.find(ext)->second, filename.c_str(), options);
 
     if (shaderModule.GetCompilationStatus() != shaderc_compilation_status_success) {
         std::cerr << shaderModule.GetErrorMessage();
         throw std::runtime_error("Shader Compilation Error: " + shaderModule.GetErrorMessage());
     }
-    std::vector<uint32_t> compiled { shaderModule.cbegin(), shaderModule.cend() };
+    std::cout << "Shader compiled: " + shaderPath.string() << '\n';
 
-    const char* data = reinterpret_cast<const char*>(compiled.data());
-    std::ofstream shaderFile(path + ".spv", std::ios::ate | std::ios::binary);
-    shaderFile.clear();
-    shaderFile.write(data, strlen(data) * compiled.size());
-    shaderFile.close();
+    const char* begin = reinterpret_cast<const char*>(shaderModule.cbegin());
+    const char* end = reinterpret_cast<const char*>(shaderModule.cend());
+    return std::vector<char>(begin, end);
 }
 
-std::map<std::string, std::filesystem::directory_entry> ShaderCompiler::listModifiedFiles()
+/* Key is FNV-1a hash of compile options, shader stage, shader source and every included file with
+   its name. Included files are hashed in name order, so key does not depend on include order. */
+uint64_t ShaderCompiler::createCacheKey(const std::filesystem::path& shaderPath, const std::string& shaderCode)
 {
-    std::map<std::string, std::filesystem::directory_entry> filePaths {};
-    std::map<std::string, std::filesystem::directory_entry> compilePaths {};
-    std::filesystem::path rootPath(PATH_PARAMS.SHADER_PATH);
-
-    auto dit = std::filesystem::directory_iterator { rootPath };
-    for (const std::filesystem::directory_entry& entry : dit) {
-        if (entry.is_regular_file()) {
-            filePaths.insert({ entry.path().filename().string(), entry });
-        }
+    uint64_t cacheKey = hash(compileOptionsKey, fnvOffsetBasis);
+    cacheKey = hash(shaderPath.extension().string(), cacheKey);
+    cacheKey = hash(shaderCode, cacheKey);
+
+    std::set<std::string> includes {};
+    collectIncludes(shaderCode, includes);
+    for (const std::string& include : includes) {
+        cacheKey = hash(include, cacheKey);
+        cacheKey = hash(readFile(std::filesystem::path(PATH_PARAMS.SHADER_PATH) / include), cacheKey);
     }
+    return cacheKey;
+}
 
-    for (const auto& entry : filePaths) {
-        bool spvFile = entry.second.path().extension() == ".spv";
-
-        if (!spvFile) {
-            std::string spv = entry.first + ".spv";
-
-            if (filePaths.contains(spv) && entry.second.last_write_time() < filePaths[spv].last_write_time()) {
-                std::string spvPath = entry.second.path().string() + ".spv";
-                std::vector<char> compiledShader = readShaderFile(spvPath, true);
-                compiledShaders.insert({ spv, compiledShader });
-            } else {
-                compilePaths.insert(entry);
-            }
+void ShaderCompiler::collectIncludes(const std::string& shaderCode, std::set<std::string>& includes)
+{
+    std::istringstream shaderStream(shaderCode);
+    std::string line;
+    std::smatch match;
+    while (std::getline(shaderStream, line)) {
+        if (std::regex_search(line, match, includeDirective) && includes.insert(match[1].str()).second) {
+            collectIncludes(readFile(std::filesystem::path(PATH_PARAMS.SHADER_PATH) / match[1].str()), includes);
         }
     }
-    return compilePaths;
 }
 
-std::vector<char> ShaderCompiler::readShaderFile(const std::string& shaderPath, bool spvShader)
+// Separator is hashed after data, so concatenation of different parts does not produce the same key.
+uint64_t ShaderCompiler::hash(const std::string& data, uint64_t seed)
 {
-    std::ifstream shaderFile(shaderPath, std::ios::ate | std::ios::binary);
-
-    if (!shaderFile.is_open()) {
-        throw std::runtime_error("Failed to open shader file.");
+    uint64_t value = seed;
+    for (const unsigned char byte : data) {
+        value = (value ^ byte) * fnvPrime;
     }
+    return (value ^ 0xFF) * fnvPrime;
+}
 
-    size_t fileSize = static_cast<size_t>(shaderFile.tellg());
-    std::vector<char> buffer(fileSize + !spvShader);
-    shaderFile.seekg(0);
-    shaderFile.read(buffer.data(), fileSize);
-    shaderFile.close();
+std::string ShaderCompiler::readFile(const std::filesystem::path& path)
+{
+    std::ifstream file(path, std::ios::ate | std::ios::binary);
 
-    if (!spvShader) {
-        buffer[fileSize] = '\0';
+    if (!file.is_open()) {
+        throw std::runtime_error("Failed to open shader file " + path.string());
     }
 
+    const size_t fileSize = static_cast<size_t>(file.tellg());
+    std::string buffer(fileSize, '\0');
+    file.seekg(0);
+    file.read(buffer.data(), fileSize);
+
     return buffer;
 }
 
+shaderc_include_result* ShaderCompiler::Includer::GetInclude(const char* requestedSource, shaderc_include_type type,
+    const char* requestingSource, size_t includeDepth)
+{
+    // First string is resolved file name and second is its content, or error message when file name is empty.
+    auto* includeData = new std::pair<std::string, std::string>();
+    const std::filesystem::path includePath = std::filesystem::path(PATH_PARAMS.SHADER_PATH) / requestedSource;
+    try {
+        includeData->second = readFile(includePath);
+        includeData->first = includePath.string();
+    } catch (const std::exception& err) {
+        includeData->second = err.what();
+    }
+
+    shaderc_include_result* includeResult = new shaderc_include_result {};
+    includeResult->source_name = includeData->first.c_str();
+    includeResult->source_name_length = includeData->first.size();
+    includeResult->content = includeData->second.c_str();
+    includeResult->content_length = includeData->second.size();
+    includeResult->user_data = includeData;
+    return includeResult;
+}
+
+void ShaderCompiler::Includer::ReleaseInclude(shaderc_include_result* data)
+{
+    delete static_cast<std::pair<std::string, std::string>*>(data->user_data);
+    delete data;
+}
+
 std::map<std::string, std::vector<char>> ShaderCompiler::getCompiledShaders()
 {
     return compiledShaders;
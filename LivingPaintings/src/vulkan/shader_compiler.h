@@ -3,16 +3,34 @@
 #include "shaderc/shaderc.hpp"
 #include <algorithm>
 #include <filesystem>
+#include <format>
 #include <fstream>
+#include <future>
 #include <iostream>
 #include <map>
+#include <regex>
+#include <set>
+#include <sstream>
 #include <stdexcept>
 #include <string>
 
+/* Compiled SPIR-V is addressed by hash of shader source, sources of included files and compile
+   options. Current shaders are kept in memory and every compiled version in the cache folder, so unchanged
+   shaders are loaded without invoking shaderc, and shaders that must be compiled are compiled in parallel. */
 class ShaderCompiler {
-    static std::map<std::string, std::filesystem::directory_entry> listModifiedFiles();
-    static std::vector<char> readShaderFile(const std::string& shaderPath, bool spvShader);
-    static void compile(std::filesystem::path shaderPath, const std::string& shaderCode);
+
+    // Resolves includes relative to the shader folder.
+    class Includer : public shaderc::CompileOptions::IncluderInterface {
+        shaderc_include_result* GetInclude(const char* requestedSource, shaderc_include_type type,
+            const char* requestingSource, size_t includeDepth) override;
+        void ReleaseInclude(shaderc_include_result* data) override;
+    };
+
+    static uint64_t hash(const std::string& data, uint64_t seed);
+    static std::string readFile(const std::filesystem::path& path);
+    static void collectIncludes(const std::string& shaderCode, std::set<std::string>& includes);
+    static uint64_t createCacheKey(const std::filesystem::path& shaderPath, const std::string& shaderCode);
+    static std::vector<char> compile(std::filesystem::path shaderPath, const std::string& shaderCode);
 
 public:
     static void compileIfChanged();
@@ -8,7 +8,8 @@ const int8_t spvExtNameLength = 4;
 const int8_t shaderExtNameLength = 5;
 
 VkDevice ShaderManager::device = VK_NULL_HANDLE;
-bool ShaderManager::recreateGraphicsPipeline = false;
+std::atomic<bool> ShaderManager::recreateGraphicsPipeline = false;
+std::atomic<bool> ShaderManager::stopWatching = false;
 
 const std::map<std::string, VkShaderStageFlagBits> shaderTypes {
     { ".vert", VK_SHADER_STAGE_VERTEX_BIT },
@@ -19,31 +20,39 @@ const std::map<std::string, VkShaderStageFlagBits> shaderTypes {
     { ".tese", VK_SHADER_STAGE_TESSELLATION_EVALUATION_BIT }
 };
 
-std::map<VkShaderStageFlagBits, VkShaderModule> shaderModules {};
+std::map<std::string, std::pair<VkShaderStageFlagBits, VkShaderModule>> shaderModules {};
 
-HANDLE hShaderFileChange;
-DWORD dwWaitStatus;
 std::thread fileChangeNotifyThread(ShaderManager::notifyShaderFileChange);
 
 ShaderManager::~ShaderManager()
 {
+    stopWatching = true;
     if (fileChangeNotifyThread.joinable()) {
         fileChangeNotifyThread.join();
     }
 }
 
+#ifdef _WIN32
+HANDLE hShaderFileChange;
+DWORD dwWaitStatus;
+
 void ShaderManager::notifyShaderFileChange()
 {
     std::cout << "\n[Shader Notifier] Started. Waiting for change notification..."
               << "\n";
     const char* shaderPath = PATH_PARAMS.SHADER_PATH.c_str();
 
-    while (TRUE) {
+    while (!stopWatching) {
     
         hShaderFileChange = FindFirstChangeNotificationA(
             shaderPath, false, FILE_NOTIFY_CHANGE_LAST_WRITE);
 
-        dwWaitStatus = WaitForSingleObject(hShaderFileChange, INFINITE);
+        // Wait with timeout, so watcher can be stopped.
+        dwWaitStatus = WaitForSingleObject(hShaderFileChange, 1000);
+        if (dwWaitStatus == WAIT_TIMEOUT) {
+            FindCloseChangeNotification(hShaderFileChange);
+            continue;
+        }
         std::this_thread::sleep_for(100ms);
         if (FindNextChangeNotification(hShaderFileChange)) {
             std::cout << "\n[Shader Notifier] Shader files directory changed."
@@ -67,27 +76,81 @@ void ShaderManager::notifyShaderFileChange()
             break;
         }
     }
+}
+#else
+/* Closing of written file and moving file into the directory are watched, so editors that save
+   through a temporary file are noticed too. Events are merged until directory is quiet for the
+   poll timeout. Compiled .spv files are written to the same directory and are ignored. */
+void ShaderManager::notifyShaderFileChange()
+{
+    std::cout << "\n[Shader Notifier] Started. Waiting for change notification..."
+              << "\n";
+    const int inotifyFd = inotify_init1(IN_NONBLOCK);
+    if (inotifyFd < 0 || inotify_add_watch(inotifyFd, PATH_PARAMS.SHADER_PATH.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0) {
+        std::cout << "\n[Shader Notifier] Stopping. Failed to notify."
+                  << "\n";
+        if (inotifyFd >= 0) {
+            close(inotifyFd);
+        }
+        return;
+    }
 
-    delete shaderPath;
+    alignas(inotify_event) char eventBuffer[4096];
+    pollfd pollFd { inotifyFd, POLLIN, 0 };
+    bool shaderChanged = false;
+    while (!stopWatching) {
+        const int readyCount = poll(&pollFd, 1, 100);
+        if (readyCount < 0) {
+            break;
+        }
+        if (readyCount == 0) {
+            if (shaderChanged) {
+                std::cout << "\n[Shader Notifier] Shader files directory changed."
+                          << "\n";
+                recreateGraphicsPipeline = true;
+                shaderChanged = false;
+            }
+            continue;
+        }
+
+        const ssize_t length = read(inotifyFd, eventBuffer, sizeof(eventBuffer));
+        for (ssize_t offset = 0; offset < length;) {
+            const inotify_event* event = reinterpret_cast<const inotify_event*>(eventBuffer + offset);
+            if (event->len > 0 && !std::string(event->name).ends_with(".spv")) {
+                shaderChanged = true;
+            }
+            offset += sizeof(inotify_event) + event->len;
+        }
+    }
+    close(inotifyFd);
 }
+#endif
 
-void ShaderManager::createShaderModules(VkDevice& device)
+/* SPIR-V embedded at build time is used until shader sources are changed, so cold start does not
+   compile shaders. Sources are compiled when nothing is embedded, e.g. glslc was not found at build time. */
+void ShaderManager::createShaderModules(VkDevice& device, bool compileSources)
 {
     ShaderManager::device = device;
 
-    ShaderCompiler::compileIfChanged();
+    std::map<std::string, std::vector<char>> compiledShaders {};
+    if (compileSources || EmbeddedShaders::SHADERS.empty()) {
+        ShaderCompiler::compileIfChanged();
+        compiledShaders = ShaderCompiler::getCompiledShaders();
+    } else {
+        for (const EmbeddedShaders::Shader& shader : EmbeddedShaders::SHADERS) {
+            const char* code = reinterpret_cast<const char*>(shader.code);
+            compiledShaders.insert({ std::string(shader.name) + ".spv", std::vector<char>(code, code + shader.size) });
+        }
+    }
 
-    for (std::pair<std::string, std::vector<char>> shader : ShaderCompiler::getCompiledShaders()) {
+    for (std::pair<std::string, std::vector<char>> shader : compiledShaders) {
         VkShaderModule shaderModule = createShaderModule(shader.second);
         uint32_t index = shader.first.size() - spvExtNameLength;
+        std::string shaderName = shader.first.substr(0, index);
         std::string ext = shader.first.substr(index - shaderExtNameLength,
             shaderExtNameLength);
         VkShaderStageFlagBits shaderType = shaderTypes.find(ext)->second;
-        if (shaderModules.contains(shaderType)) {
-            shaderModules[shaderType] = shaderModule;
-        } else {
-            shaderModules.insert({ shaderType, shaderModule });
-        }
+        shaderModules.insert_or_assign(shaderName, std::make_pair(shaderType, shaderModule));
     }
 }
 
@@ -108,12 +171,13 @@ VkShaderModule ShaderManager::createShaderModule(std::vector<char> shaderCode)
 
 void ShaderManager::destroyShaderModules()
 {
-    for (const std::pair<const VkShaderStageFlagBits, VkShaderModule_T*>& shaderModule : shaderModules) {
-        vkDestroyShaderModule(device, shaderModule.second, nullptr);
+    for (const auto& shaderModule : shaderModules) {
+        vkDestroyShaderModule(device, shaderModule.second.second, nullptr);
     }
+    shaderModules.clear();
 }
 
-std::map<VkShaderStageFlagBits, VkShaderModule> ShaderManager::getShaderModules()
+std::map<std::string, std::pair<VkShaderStageFlagBits, VkShaderModule>> ShaderManager::getShaderModules()
 {
     return shaderModules;
 }
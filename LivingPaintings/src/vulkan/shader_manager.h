@@ -1,9 +1,17 @@
 #pragma once
 #include "shader_compiler.h"
+#include "embedded_shaders.hpp"
+#include <atomic>
 #include <iostream>
 #include <thread>
 #include <vulkan/vulkan_core.h>
+#ifdef _WIN32
 #include <windows.h>
+#else
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
 
 class ShaderManager {
 
@@ -13,9 +21,12 @@ class ShaderManager {
 
 public:
     ~ShaderManager();
-    static bool recreateGraphicsPipeline;
+    // Set by the file watcher thread and cleared by the render thread when background build starts.
+    static std::atomic<bool> recreateGraphicsPipeline;
+    static std::atomic<bool> stopWatching;
     static void notifyShaderFileChange();
-    void createShaderModules(VkDevice& device);
+    void createShaderModules(VkDevice& device, bool compileSources);
     void destroyShaderModules();
-    std::map<VkShaderStageFlagBits, VkShaderModule> getShaderModules();
+    // Shader modules keyed by shader file name, so several shaders of one stage can coexist.
+    std::map<std::string, std::pair<VkShaderStageFlagBits, VkShaderModule>> getShaderModules();
 };
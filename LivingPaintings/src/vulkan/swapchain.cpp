@@ -45,6 +45,15 @@ void Swapchain::createSpecializedImages(Queue& graphicsQueue)
 	colorImage.create(device, physicalDevice, commandPool,
 		VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT | VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT,
 		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, graphicsQueue);
+
+	// Allocated with full extent, so render scale can be changed without recreating the image.
+	sceneImage.imageDetails.createImageInfo(
+		"", extent.width, extent.height, 4, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+		VK_IMAGE_VIEW_TYPE_2D, imageFormat, VK_SHADER_STAGE_FRAGMENT_BIT,
+		VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_ASPECT_COLOR_BIT, VK_SAMPLE_COUNT_1_BIT);
+	sceneImage.create(device, physicalDevice, commandPool,
+		VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, graphicsQueue);
 }
 
 void Swapchain::create()
@@ -136,18 +145,36 @@ VkImageView& Swapchain::createImageView(VkImage& image, VkFormat& format,
 	return imageView;
 }
 
-void Swapchain::createFramebuffers(VkRenderPass& renderPass)
+void Swapchain::createFramebuffers(VkRenderPass& sceneRenderPass, VkRenderPass& presentRenderPass)
 {
+	this->sceneRenderPass = sceneRenderPass;
+	this->presentRenderPass = presentRenderPass;
 	framebuffers.resize(imageViews.size());
 
 	const VkImageView& depthImageView = depthImage.getView();
 	const VkImageView& colorImageView = colorImage.getView();
+	const VkImageView& sceneImageView = sceneImage.getView();
+	std::vector<VkImageView> sceneAttachments = { colorImageView, depthImageView, sceneImageView };
+
+	VkFramebufferCreateInfo sceneFramebufferInfo{};
+	sceneFramebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+	sceneFramebufferInfo.renderPass = sceneRenderPass;
+	sceneFramebufferInfo.attachmentCount = static_cast<uint32_t>(sceneAttachments.size());
+	sceneFramebufferInfo.pAttachments = sceneAttachments.data();
+	sceneFramebufferInfo.width = extent.width;
+	sceneFramebufferInfo.height = extent.height;
+	sceneFramebufferInfo.layers = 1;
+
+	if (vkCreateFramebuffer(device, &sceneFramebufferInfo, nullptr, &sceneFramebuffer) != VK_SUCCESS) {
+		throw std::runtime_error("Failed to create scene framebuffer.");
+	}
+
 	for (size_t i = 0; i < imageViews.size(); i++) {
-		std::vector<VkImageView> attachments = { colorImageView, depthImageView, imageViews[i] };
+		std::vector<VkImageView> attachments = { imageViews[i] };
 
 		VkFramebufferCreateInfo framebufferInfo{};
 		framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
-		framebufferInfo.renderPass = renderPass;
+		framebufferInfo.renderPass = presentRenderPass;
 		framebufferInfo.attachmentCount = static_cast<uint32_t>(attachments.size());
 		framebufferInfo.pAttachments = attachments.data();
 		framebufferInfo.width = extent.width;
@@ -160,13 +187,13 @@ void Swapchain::createFramebuffers(VkRenderPass& renderPass)
 	}
 }
 
-uint32_t Swapchain::asquireNextImage(Queue& graphicsQueue, VkRenderPass& renderPass, VkSemaphore& imageAvailable, GLFWwindow* pWindow)
+uint32_t Swapchain::asquireNextImage(Queue& graphicsQueue, VkSemaphore& imageAvailable, GLFWwindow* pWindow)
 {
 	uint32_t imageIndex;
 	VkResult result = vkAcquireNextImageKHR(this->device, swapchain, UINT64_MAX, imageAvailable, VK_NULL_HANDLE, &imageIndex);
 
 	if (result == VK_ERROR_OUT_OF_DATE_KHR) {
-		recreate(graphicsQueue, renderPass, pWindow);
+		recreate(graphicsQueue, pWindow);
 		return 0;
 	}
 	else if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR) {
@@ -176,7 +203,7 @@ uint32_t Swapchain::asquireNextImage(Queue& graphicsQueue, VkRenderPass& renderP
 	return imageIndex;
 }
 
-void Swapchain::presentImage(Queue& graphicsQueue, VkRenderPass& renderPass, VkQueue& presentationQueue,
+void Swapchain::presentImage(Queue& graphicsQueue, VkQueue& presentationQueue,
 	std::vector<VkSemaphore> signalSemafores,
 	GLFWwindow* pWindow)
 {
@@ -193,7 +220,7 @@ void Swapchain::presentImage(Queue& graphicsQueue, VkRenderPass& renderPass, VkQ
 
 	VkResult result = vkQueuePresentKHR(presentationQueue, &presentationInfo);
 	if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR || framebufferResized) {
-		recreate(graphicsQueue, renderPass, pWindow);
+		recreate(graphicsQueue, pWindow);
 		framebufferResized = false;
 		currentFrame = 0;
 		return;
@@ -220,16 +247,18 @@ void Swapchain::destroy()
 		vkDestroyFramebuffer(device, framebuffer, nullptr);
 	}
 
+	vkDestroyFramebuffer(device, sceneFramebuffer, nullptr);
+
 	imageViews.clear();
 	framebuffers.clear();
 	vkDestroySwapchainKHR(device, swapchain, nullptr);
 
 	depthImage.destroy();
 	colorImage.destroy();
+	sceneImage.destroy();
 }
 
-void Swapchain::recreate(Queue& graphicsQueue, VkRenderPass& renderPass,
-	GLFWwindow* pWindow)
+void Swapchain::recreate(Queue& graphicsQueue, GLFWwindow* pWindow)
 {
 	int width = 0, height = 0;
 	glfwGetFramebufferSize(pWindow, &width, &height);
@@ -258,7 +287,17 @@ void Swapchain::recreate(Queue& graphicsQueue, VkRenderPass& renderPass,
 	create();
 	createImageViews();
 	createSpecializedImages(graphicsQueue);
-	createFramebuffers(renderPass);
+	createFramebuffers(sceneRenderPass, presentRenderPass);
+	recreationCount++;
+}
+
+// Multisampled attachments are recreated with the swapchain, scene framebuffer uses the new render pass.
+void Swapchain::changeSampleCount(Queue& graphicsQueue, GLFWwindow* pWindow,
+	VkSampleCountFlagBits samples, VkRenderPass& sceneRenderPass)
+{
+	this->samples = samples;
+	this->sceneRenderPass = sceneRenderPass;
+	recreate(graphicsQueue, pWindow);
 }
 
 std::shared_ptr<unsigned char> Swapchain::writeFrameToBuffer(VkCommandBuffer cmds, Queue transferQueue, uint8_t currentFrame)
@@ -374,6 +413,16 @@ std::vector<VkFramebuffer>& Swapchain::getFramebuffers()
 	return framebuffers;
 }
 
+VkFramebuffer& Swapchain::getSceneFramebuffer()
+{
+	return sceneFramebuffer;
+}
+
+uint32_t Swapchain::getRecreationCount() const
+{
+	return recreationCount;
+}
+
 void Swapchain::resizeFramebuffer()
 {
 	framebufferResized = true;
@@ -402,4 +451,9 @@ Image& Swapchain::getColorImage()
 Image& Swapchain::getDepthImage()
 {
 	return depthImage;
+}
+
+Image& Swapchain::getSceneImage()
+{
+	return sceneImage;
 }
\ No newline at end of file
@@ -20,6 +20,10 @@ class Swapchain {
     uint32_t minImageCount;
     Image depthImage;
     Image colorImage;
+    Image sceneImage; // resolved painting rendered at render scale, sampled by upscale pass
+    VkFramebuffer sceneFramebuffer = VK_NULL_HANDLE;
+    VkRenderPass sceneRenderPass = VK_NULL_HANDLE;
+    VkRenderPass presentRenderPass = VK_NULL_HANDLE;
     std::vector<VkImage> images;
     std::vector<VkImageView> imageViews;
     std::vector<VkFramebuffer> framebuffers;
@@ -31,6 +35,7 @@ class Swapchain {
     VkExtent2D extent;
     uint32_t currentFrame;
     bool framebufferResized;
+    uint32_t recreationCount = 0;
 
     void createSpecializedImages(Queue& graphicsQueue);
 
@@ -42,15 +47,16 @@ public:
     VkImageView& createImageView(VkImage& image, VkFormat& format,
         VkImageAspectFlags aspectFlags);
     void createImageViews();
-    void createFramebuffers(VkRenderPass& renderPass);
-    void presentImage(Queue& graphicsQueue, VkRenderPass& renderPass,
-        VkQueue& presentationQueue,
+    void createFramebuffers(VkRenderPass& sceneRenderPass, VkRenderPass& presentRenderPass);
+    void presentImage(Queue& graphicsQueue, VkQueue& presentationQueue,
         std::vector<VkSemaphore> signalSemafores,
         GLFWwindow* window);
-    uint32_t asquireNextImage(Queue& graphicsQueue, VkRenderPass& renderPass,
+    uint32_t asquireNextImage(Queue& graphicsQueue,
         VkSemaphore& imageAvailable, GLFWwindow* window);
     void nextFrame();
-    void recreate(Queue& graphicsQueue, VkRenderPass& renderPass, GLFWwindow* window);
+    void recreate(Queue& graphicsQueue, GLFWwindow* window);
+    void changeSampleCount(Queue& graphicsQueue, GLFWwindow* window,
+        VkSampleCountFlagBits samples, VkRenderPass& sceneRenderPass);
     void destroy();
     
     std::shared_ptr<unsigned char> writeFrameToBuffer(VkCommandBuffer cmd, Queue transferQueue, uint8_t currentFrame);
@@ -61,6 +67,8 @@ public:
     VkExtent2D& getExtent();
     std::vector<VkImageView>& getImageViews();
     std::vector<VkFramebuffer>& getFramebuffers();
+    VkFramebuffer& getSceneFramebuffer();
+    uint32_t getRecreationCount() const;
     uint32_t& getCurrentFrame();
     void resizeFramebuffer();
     VkDevice& getDevice();
@@ -68,4 +76,5 @@ public:
     VkCommandPool& getCommandPool();
     Image& getColorImage();
     Image& getDepthImage();
+    Image& getSceneImage();
 };
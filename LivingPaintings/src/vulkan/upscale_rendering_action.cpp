@@ -0,0 +1,74 @@
+#include "upscale_rendering_action.h"
+
+/* Scene image has swapchain extent, where painting occupies only top left part of it
+   with render extent, so texture coordinates are scaled to that part. */
+void UpscaleRenderingAction::setContext(Pipeline& pipeline,
+    VkExtent2D extent, VkExtent2D renderExtent, float sharpness)
+{
+    this->upscalePipelineLayout = pipeline.getUpscaleLayout();
+    this->upscalePipeline = pipeline.getUpscale();
+    this->extent = extent;
+
+    pushConstants.uvScale = glm::vec2(renderExtent.width, renderExtent.height) / glm::vec2(extent.width, extent.height);
+    pushConstants.texelSize = glm::vec2(1.0f) / glm::vec2(extent.width, extent.height);
+    pushConstants.sharpness = sharpness;
+}
+
+void UpscaleRenderingAction::beginRenderPass(
+    VkCommandBuffer& cmdGraphics, VkRenderPass& renderPass,
+    std::vector<VkFramebuffer>& framebuffers,
+    uint32_t currentFrame)
+{
+    VkRenderPassBeginInfo renderPassBegin {};
+    renderPassBegin.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+    renderPassBegin.renderPass = renderPass;
+    renderPassBegin.framebuffer = framebuffers[currentFrame];
+    renderPassBegin.renderArea.offset = { 0, 0 };
+    renderPassBegin.renderArea.extent = extent;
+    renderPassBegin.clearValueCount = 0;
+    renderPassBegin.pClearValues = nullptr;
+
+    vkCmdBeginRenderPass(cmdGraphics, &renderPassBegin,
+        VK_SUBPASS_CONTENTS_INLINE);
+
+    vkCmdBindPipeline(cmdGraphics, VK_PIPELINE_BIND_POINT_GRAPHICS,
+        upscalePipeline);
+}
+
+void UpscaleRenderingAction::recordCommandBuffer(VkCommandBuffer& commandBuffer,
+    VkDescriptorSet& descriptorSet,
+    VkDescriptorSet& bindlessDescriptorSet)
+{
+    VkViewport viewport {};
+    viewport.x = 0.0f;
+    viewport.y = 0.0f;
+    viewport.width = static_cast<float>(extent.width);
+    viewport.height = static_cast<float>(extent.height);
+    viewport.minDepth = 0.0f;
+    viewport.maxDepth = 1.0f;
+    vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+
+    VkRect2D scissor {};
+    scissor.offset = { 0, 0 };
+    scissor.extent = extent;
+    vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+
+    vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS,
+        upscalePipelineLayout, 0, 1, &descriptorSet,
+        0, nullptr);
+
+    vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS,
+        upscalePipelineLayout, 1, 1, &bindlessDescriptorSet,
+        0, nullptr);
+
+    vkCmdPushConstants(commandBuffer, upscalePipelineLayout, VK_SHADER_STAGE_FRAGMENT_BIT,
+        0, sizeof(UpscalePushConstants), &pushConstants);
+
+    // fullscreen triangle, vertices are generated in upscale.vert
+    vkCmdDraw(commandBuffer, 3, 1, 0, 0);
+}
+
+void UpscaleRenderingAction::endRenderPass(VkCommandBuffer& commandBuffer)
+{
+    vkCmdEndRenderPass(commandBuffer);
+}
@@ -0,0 +1,25 @@
+#pragma once
+#include "command_buffer.h"
+#include "pipeline.h"
+#include "vulkan/vulkan.h"
+#include <stdexcept>
+#include <vector>
+
+class UpscaleRenderingAction {
+
+    VkPipelineLayout upscalePipelineLayout = VK_NULL_HANDLE;
+    VkPipeline upscalePipeline = VK_NULL_HANDLE;
+    VkExtent2D extent {};
+    UpscalePushConstants pushConstants {};
+
+public:
+    void setContext(Pipeline& pipeline, VkExtent2D extent, VkExtent2D renderExtent, float sharpness);
+    void beginRenderPass(VkCommandBuffer& cmdGraphics,
+        VkRenderPass& renderPass,
+        std::vector<VkFramebuffer>& framebuffers,
+        uint32_t currentFrame);
+    void recordCommandBuffer(VkCommandBuffer& commandBuffer,
+        VkDescriptorSet& descriptorSet,
+        VkDescriptorSet& bindlessDescriptorSet);
+    void endRenderPass(VkCommandBuffer& commandBuffer);
+};
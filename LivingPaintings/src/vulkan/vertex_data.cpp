@@ -42,11 +42,6 @@ const std::map<uint16_t, uint8_t> CHECKED_REGIONS_TO_POINT_GRANULARITY {
     { 1000, 50 }, { 300, 20 }, { 150, 15 }, { 100, 10 }, { 80, 5 }, { 40, 4 }
 };
 
-size_t Data::AlignmentProperties::minUniformAlignment = 0;
-size_t Data::AlignmentProperties::dynamicUniformAlignment_mat4 = 0;
-
-size_t Data::RuntimeProperties::uboMemorySize = 0;
-
 uint16_t Data::GraphicsObject::s_instanceId = 0;
 Data::GraphicsObject::Instance Data::GraphicsObject::instanceUniform {};
 Data::GraphicsObject::View Data::GraphicsObject::viewUniform {};
@@ -81,8 +76,10 @@ Data::GraphicsObject::Vertex::getAttributeDescriptions()
 
 void Data::GraphicsObject::Instance::allocateInstances()
 {
-    RuntimeProperties::uboMemorySize = Constants::OBJECT_INSTANCES * AlignmentProperties::dynamicUniformAlignment_mat4;
-    model = (glm::mat4*)alignedAlloc(RuntimeProperties::uboMemorySize, AlignmentProperties::dynamicUniformAlignment_mat4);
+    instances.clear();
+    instances.reserve(Constants::OBJECT_INSTANCES);
+    dirtyBegin = 0;
+    dirtyEnd = 0;
 }
 
 void Data::GraphicsObject::Instance::move(ObjectParams params, glm::mat4 mat)
@@ -173,17 +170,42 @@ void Data::GraphicsObject::Instance::scale(ObjectParams params, float time)
     *modelMat = glm::scale(*modelMat, time * glm::vec3(params.scale[0], params.scale[1], params.scale[2]));
 }
 
-glm::mat4* Data::GraphicsObject::Instance::translationMatrix(uint16_t instanceIndex) const
+// Returned pointer is invalidated when instance with greater index is written.
+glm::mat4* Data::GraphicsObject::Instance::translationMatrix(uint16_t instanceIndex)
+{
+    if (instanceIndex >= instances.size()) {
+        instances.resize(instanceIndex + 1, InstanceData { IDENTITY_MAT_4, Constants::BACKGROUND_TEXTURE_SLOT });
+    }
+
+    if (dirtyBegin == dirtyEnd) {
+        dirtyBegin = instanceIndex;
+        dirtyEnd = instanceIndex + 1;
+    } else {
+        dirtyBegin = std::min<size_t>(dirtyBegin, instanceIndex);
+        dirtyEnd = std::max<size_t>(dirtyEnd, instanceIndex + 1);
+    }
+    return &instances[instanceIndex].model;
+}
+
+void Data::GraphicsObject::Instance::setTextureSlot(uint16_t instanceIndex, uint32_t textureSlot)
 {
-    uint64_t mstartaddr = reinterpret_cast<uint64_t>(model);
-    size_t uboOffset = instanceIndex * AlignmentProperties::dynamicUniformAlignment_mat4;
-    glm::mat4* modelMat = reinterpret_cast<glm::mat4*>(mstartaddr + uboOffset);
-    return modelMat;
+    translationMatrix(instanceIndex);
+    instances[instanceIndex].textureSlot = textureSlot;
+}
+
+std::pair<size_t, size_t> Data::GraphicsObject::Instance::takeDirtyRange()
+{
+    const std::pair<size_t, size_t> dirtyRange = { dirtyBegin, dirtyEnd };
+    dirtyBegin = 0;
+    dirtyEnd = 0;
+    return dirtyRange;
 }
 
 void Data::GraphicsObject::Instance::destroy()
 {
-    alignedFree(instanceUniform.model);
+    instances.clear();
+    dirtyBegin = 0;
+    dirtyEnd = 0;
 }
 
 void Data::GraphicsObject::View::cameraView(CameraParams& params,
@@ -259,18 +281,6 @@ void Data::GraphicsObject::constructQuadsWithAspectRatio(uint16_t width,
     indices = { 0, 1, 2, 2, 3, 0, 4, 5, 6, 6, 7, 4 };
 }
 
-/* Set uniform dynamic properties for dynamic buffers.
-   minUboAlignment - parameter must be taken from device properties.
-   */
-void Data::setUniformDynamicAlignments(size_t minUboAlignment)
-{
-    AlignmentProperties::minUniformAlignment = minUboAlignment;
-    AlignmentProperties::dynamicUniformAlignment_mat4 = sizeof(glm::mat4);
-    if (minUboAlignment > 0) {
-        AlignmentProperties::dynamicUniformAlignment_mat4 = (AlignmentProperties::dynamicUniformAlignment_mat4 + minUboAlignment - 1) & ~(minUboAlignment - 1);
-    }
-}
-
 /* Constructs mesh from mask texture by gathering points from mask texture and using Alpha shape method to build
    mesh from specified points. When gathering point, point granularity in the mask texture is checked. In accordance
    with point granularity, points will be added to array if they was selected and they dont have all neighbouring
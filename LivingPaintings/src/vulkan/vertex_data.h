@@ -1,7 +1,5 @@
 #pragma once
 
-#include "../utils/alloc.h"
-
 #include "consts.h"
 #include "gui_params.h"
 #include "vulkan/vulkan.h"
@@ -18,24 +16,38 @@
 
 namespace Data {
 
-struct AlignmentProperties {
-    static size_t minUniformAlignment;
-    static size_t dynamicUniformAlignment_mat4;
-};
-
 struct RuntimeProperties {
-    static size_t uboMemorySize;
     static float time;
 };
 
+// Uniforms that are shared by all objects of a frame, stored in the frame uniform ring buffer.
+enum FrameUniform : uint32_t {
+    MOUSE_CONTROL_UNIFORM,
+    TIME_UNIFORM,
+    EFFECT_PARAMS_UNIFORM,
+    LIGHT_PARAMS_UNIFORM,
+    BRUSH_STROKE_UNIFORM
+};
+
 struct GraphicsObject {
     static uint16_t s_instanceId;
 
+    // Matches std430 layout of InstanceData in painting.vert, instances are indexed with gl_InstanceIndex.
+    struct InstanceData {
+        glm::mat4 model;
+        uint32_t textureSlot; // element of bindless texture array
+        uint32_t padding[3];
+    };
+
     static struct Instance {
         static const glm::mat3 IDENTITY_MAT_3;
         static const glm::mat4 IDENTITY_MAT_4;
 
-        glm::mat4* model { nullptr };
+        /* Grows when instance with greater index is written. Range of instances written since the last
+           takeDirtyRange call is tracked, so only that range is uploaded to instance buffers. */
+        std::vector<InstanceData> instances;
+        size_t dirtyBegin = 0;
+        size_t dirtyEnd = 0;
 
         void allocateInstances();
         void move(ObjectParams params, const glm::mat4 translationMatrix = IDENTITY_MAT_4);
@@ -45,7 +57,9 @@ struct GraphicsObject {
         void move(ObjectParams params, float time);
         void rotate(ObjectParams params, float time);
         void scale(ObjectParams params, float time);
-        glm::mat4* translationMatrix(uint16_t instanceIndex) const;
+        glm::mat4* translationMatrix(uint16_t instanceIndex);
+        void setTextureSlot(uint16_t instanceIndex, uint32_t textureSlot);
+        std::pair<size_t, size_t> takeDirtyRange();
         void destroy();
     } instanceUniform;
 
@@ -68,6 +82,7 @@ struct GraphicsObject {
     };
 
     uint16_t instanceId = s_instanceId++;
+    uint32_t textureSlot = Constants::BACKGROUND_TEXTURE_SLOT; // element of bindless texture array
     std::vector<Vertex> vertices;
     std::vector<uint16_t> indices;
 
@@ -79,6 +94,4 @@ struct GraphicsObject {
         float selectedDepth, const unsigned char* pixels,
         uint16_t alphaPercentage);
 };
-
-void setUniformDynamicAlignments(size_t minUboAlignment);
 } // namespace Data